@@ -0,0 +1,197 @@
+#include <pebble.h>
+#include "pebble-layout.h"
+
+// Parses each reference layout with the counting allocator and fails if any number is worse
+// than the baseline, or if destroying the layout does not give everything back.
+// Usage: alloc-test <layouts directory> <baseline file> [--write]
+
+#define RESOURCE_LAYOUT 100
+
+enum {
+    RESOURCE_BACKGROUND = 1,
+    RESOURCE_BATTERY,
+    RESOURCE_BLUETOOTH,
+    RESOURCE_WEATHER,
+    RESOURCE_CLOCK_FONT
+};
+
+typedef void (*ScenarioFunc)(Layout *layout);
+
+struct Scenario {
+    const char *name;
+    ScenarioFunc run;
+};
+
+struct Result {
+    char name[32];
+    uint32_t calls;
+    size_t bytes;
+    size_t peak_live_bytes;
+    size_t peak_heap_bytes;
+    size_t fragmentation_bytes;
+};
+
+// Shows the lazy panel, sets every binding and lets the redraw run, then destroys the panel.
+static void prv_use_features(Layout *layout) {
+    layout_set_value(layout, "title", "Heart rate");
+    layout_set_value_int(layout, "value", 72);
+    layout_show(layout, "details");
+    layout_set_value(layout, "detail1", "Resting 58");
+    layout_set_value(layout, "detail2", "Peak 141");
+    host_run_timers();
+    layout_hide(layout, "details", true);
+}
+
+static const struct Scenario s_scenarios[] = {
+    { "watchface", NULL },
+    { "list", NULL },
+    { "nested", NULL },
+    { "features", prv_use_features }
+};
+
+static char *prv_read_file(const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = malloc(size + 1);
+    size_t read = fread(text, 1, size, file);
+    text[read] = '\0';
+    fclose(file);
+    return text;
+}
+
+static void prv_run(const struct Scenario *scenario) {
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_system_fonts(layout);
+    layout_add_resource(layout, "BACKGROUND", RESOURCE_BACKGROUND);
+    layout_add_resource(layout, "BATTERY", RESOURCE_BATTERY);
+    layout_add_resource(layout, "BLUETOOTH", RESOURCE_BLUETOOTH);
+    layout_add_resource(layout, "WEATHER", RESOURCE_WEATHER);
+    layout_add_font(layout, "CLOCK", RESOURCE_CLOCK_FONT);
+    layout_parse(layout, RESOURCE_LAYOUT);
+    if (scenario->run) scenario->run(layout);
+    layout_destroy(layout);
+}
+
+static bool prv_measure(const char *dir, const struct Scenario *scenario, struct Result *result) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.json", dir, scenario->name);
+    char *text = prv_read_file(path);
+    if (!text) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    host_resource_set(RESOURCE_LAYOUT, text, strlen(text));
+
+    // The first run fills caches that outlive a layout, like the shared bitmap table.
+    prv_run(scenario);
+
+    HostAllocStats stats;
+    host_alloc_get_stats(&stats);
+    size_t live_bytes = stats.live_bytes;
+    host_alloc_reset();
+    prv_run(scenario);
+    host_alloc_get_stats(&stats);
+    free(text);
+
+    snprintf(result->name, sizeof(result->name), "%s", scenario->name);
+    result->calls = stats.calls;
+    result->bytes = stats.bytes;
+    result->peak_live_bytes = stats.peak_live_bytes - live_bytes;
+    result->peak_heap_bytes = stats.peak_heap_bytes;
+    result->fragmentation_bytes = stats.fragmentation_bytes;
+    if (stats.live_bytes != live_bytes) {
+        fprintf(stderr, "%s: %d bytes still allocated after layout_destroy()\n", scenario->name,
+            (int) (stats.live_bytes - live_bytes));
+        return false;
+    }
+    return true;
+}
+
+static bool prv_find_baseline(FILE *file, const char *name, struct Result *baseline) {
+    char line[256];
+    rewind(file);
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == '#') continue;
+        unsigned long calls, bytes, peak_live, peak_heap, fragmentation;
+        if (sscanf(line, "%31s %lu %lu %lu %lu %lu", baseline->name, &calls, &bytes, &peak_live, &peak_heap,
+                &fragmentation) != 6) continue;
+        if (strcmp(baseline->name, name) != 0) continue;
+        baseline->calls = calls;
+        baseline->bytes = bytes;
+        baseline->peak_live_bytes = peak_live;
+        baseline->peak_heap_bytes = peak_heap;
+        baseline->fragmentation_bytes = fragmentation;
+        return true;
+    }
+    return false;
+}
+
+static bool prv_check(const char *name, const char *what, size_t value, size_t limit) {
+    if (value <= limit) return true;
+    fprintf(stderr, "%s: %s went from %d to %d\n", name, what, (int) limit, (int) value);
+    return false;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <layouts directory> <baseline file> [--write]\n", argv[0]);
+        return 2;
+    }
+    bool write = argc > 3 && strcmp(argv[3], "--write") == 0;
+#ifdef JSON_PACKED_TOKENS
+    bool compare = !write;
+#else
+    // The baseline is recorded with packed tokens, which wide ones always exceed.
+    if (write) {
+        fprintf(stderr, "record the baseline without JSON_WIDE_TOKENS\n");
+        return 2;
+    }
+    bool compare = false;
+#endif
+
+    struct Result results[ARRAY_LENGTH(s_scenarios)];
+    bool ok = true;
+    for (size_t i = 0; i < ARRAY_LENGTH(s_scenarios); i++) {
+        ok = prv_measure(argv[1], &s_scenarios[i], &results[i]) && ok;
+    }
+
+    FILE *file = fopen(argv[2], write ? "w" : "r");
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", argv[2]);
+        return 2;
+    }
+    if (write) fprintf(file, "# layout calls bytes peak_live_bytes peak_heap_bytes fragmentation_bytes\n");
+
+    printf("%-10s %7s %8s %10s %10s %14s\n", "layout", "calls", "bytes", "peak live", "peak heap", "fragmentation");
+    for (size_t i = 0; i < ARRAY_LENGTH(s_scenarios); i++) {
+        struct Result *result = &results[i];
+        printf("%-10s %7d %8d %10d %10d %14d\n", result->name, (int) result->calls, (int) result->bytes,
+            (int) result->peak_live_bytes, (int) result->peak_heap_bytes, (int) result->fragmentation_bytes);
+        if (write) {
+            fprintf(file, "%s %d %d %d %d %d\n", result->name, (int) result->calls, (int) result->bytes,
+                (int) result->peak_live_bytes, (int) result->peak_heap_bytes, (int) result->fragmentation_bytes);
+            continue;
+        }
+        if (!compare) continue;
+        struct Result baseline;
+        if (!prv_find_baseline(file, result->name, &baseline)) {
+            fprintf(stderr, "%s: no baseline, run make baseline\n", result->name);
+            ok = false;
+            continue;
+        }
+        ok = prv_check(result->name, "calls", result->calls, baseline.calls) && ok;
+        ok = prv_check(result->name, "bytes", result->bytes, baseline.bytes) && ok;
+        ok = prv_check(result->name, "peak live bytes", result->peak_live_bytes, baseline.peak_live_bytes) && ok;
+        ok = prv_check(result->name, "peak heap bytes", result->peak_heap_bytes, baseline.peak_heap_bytes) && ok;
+        ok = prv_check(result->name, "fragmentation bytes", result->fragmentation_bytes, baseline.fragmentation_bytes) && ok;
+    }
+    fclose(file);
+
+    if (compare) printf(ok ? "allocations within baseline\n" : "allocations regressed\n");
+    else if (!write) printf(ok ? "no leaks, baseline not compared with wide tokens\n" : "allocations leaked\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <string.h>
+#include "host-alloc.h"
+
+// Built without HOST_COUNT_ALLOCS' macros, so malloc and free here are the real ones.
+
+#define MODEL_HEADER 8
+#define MODEL_ALIGN 8
+
+struct Header {
+    size_t size;
+    size_t offset;
+    size_t model_size;
+};
+
+// Keeps the pointer handed out as aligned as malloc's.
+union Block {
+    struct Header header;
+    max_align_t align;
+};
+
+// A free range of the modelled heap, kept in address order.
+struct Hole {
+    size_t offset;
+    size_t size;
+    struct Hole *next;
+};
+
+static HostAllocStats s_stats;
+static struct Hole *s_holes;
+static size_t s_top;
+static size_t s_used;
+
+static size_t prv_model_alloc(size_t size) {
+    for (struct Hole **link = &s_holes; *link; link = &(*link)->next) {
+        struct Hole *hole = *link;
+        if (hole->size < size) continue;
+        size_t offset = hole->offset;
+        hole->offset += size;
+        hole->size -= size;
+        if (!hole->size) {
+            *link = hole->next;
+            free(hole);
+        }
+        return offset;
+    }
+    size_t offset = s_top;
+    s_top += size;
+    return offset;
+}
+
+static void prv_model_free(size_t offset, size_t size) {
+    struct Hole *prev = NULL;
+    struct Hole *next = s_holes;
+    while (next && next->offset < offset) {
+        prev = next;
+        next = next->next;
+    }
+
+    struct Hole *hole = prev;
+    if (prev && prev->offset + prev->size == offset) {
+        prev->size += size;
+    } else {
+        hole = malloc(sizeof(struct Hole));
+        hole->offset = offset;
+        hole->size = size;
+        hole->next = next;
+        if (prev) {
+            prev->next = hole;
+        } else {
+            s_holes = hole;
+        }
+    }
+    if (next && hole->offset + hole->size == next->offset) {
+        hole->size += next->size;
+        hole->next = next->next;
+        free(next);
+    }
+
+    // A hole at the top is just the heap getting smaller again.
+    if (hole->offset + hole->size != s_top) return;
+    struct Hole **link = &s_holes;
+    while (*link != hole) link = &(*link)->next;
+    *link = NULL;
+    s_top = hole->offset;
+    free(hole);
+}
+
+static void *prv_alloc(size_t size) {
+    union Block *block = malloc(sizeof(union Block) + size);
+    if (!block) return NULL;
+    size_t model_size = MODEL_HEADER + (size + MODEL_ALIGN - 1) / MODEL_ALIGN * MODEL_ALIGN;
+    block->header.size = size;
+    block->header.model_size = model_size;
+    block->header.offset = prv_model_alloc(model_size);
+
+    s_used += model_size;
+    s_stats.calls++;
+    s_stats.bytes += size;
+    s_stats.live_bytes += size;
+    s_stats.live_blocks++;
+    if (s_stats.live_bytes > s_stats.peak_live_bytes) s_stats.peak_live_bytes = s_stats.live_bytes;
+    if (s_top > s_stats.peak_heap_bytes) {
+        s_stats.peak_heap_bytes = s_top;
+        s_stats.fragmentation_bytes = s_top - s_used;
+    }
+    return block + 1;
+}
+
+static void prv_free(union Block *block) {
+    prv_model_free(block->header.offset, block->header.model_size);
+    s_used -= block->header.model_size;
+    s_stats.live_bytes -= block->header.size;
+    s_stats.live_blocks--;
+    free(block);
+}
+
+void *host_malloc(size_t size) {
+    return prv_alloc(size);
+}
+
+void *host_calloc(size_t count, size_t size) {
+    void *ptr = prv_alloc(count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+// Like the watch's, a new block is taken before the old one is given back.
+void *host_realloc(void *ptr, size_t size) {
+    if (!ptr) return prv_alloc(size);
+    union Block *old = (union Block *) ptr - 1;
+    void *copy = prv_alloc(size);
+    if (!copy) return NULL;
+    memcpy(copy, ptr, old->header.size < size ? old->header.size : size);
+    prv_free(old);
+    return copy;
+}
+
+void host_free(void *ptr) {
+    if (ptr) prv_free((union Block *) ptr - 1);
+}
+
+void host_alloc_reset(void) {
+    s_stats.calls = 0;
+    s_stats.bytes = 0;
+    s_stats.peak_live_bytes = s_stats.live_bytes;
+    s_stats.peak_heap_bytes = s_top;
+    s_stats.fragmentation_bytes = s_top - s_used;
+}
+
+void host_alloc_get_stats(HostAllocStats *stats) {
+    *stats = s_stats;
+}
+
+size_t host_alloc_heap_used(void) {
+    return s_used;
+}
@@ -0,0 +1,177 @@
+#include <pebble.h>
+#include <stdarg.h>
+#include "json.h"
+#include "pebble-layout.h"
+
+// Parses and destroys generated layouts of several shapes and sizes and reports how fast.
+// Usage: bench [seconds per case] [shape]
+
+#define BENCH_NUM_BITMAPS 8
+// Each level opens an object and an array, so this goes past the JSMN_MAX_DEPTH the tokenizer
+// keeps track of and also measures its fallback.
+#define BENCH_DEPTH 20
+
+struct Buffer {
+    char *text;
+    size_t len;
+    size_t size;
+};
+
+typedef void (*ShapeFunc)(struct Buffer *buffer, int n);
+
+struct Shape {
+    const char *name;
+    ShapeFunc child;
+};
+
+static const size_t s_sizes[] = { 1024, 4096, 16384, 65536 };
+
+static const char *s_words[] = {
+    "weather", "steps", "battery", "sunrise", "calendar", "heart", "rate", "goal",
+    "minutes", "today", "tomorrow", "cloudy", "meeting", "distance", "sleep", "alarm"
+};
+
+static void prv_append(struct Buffer *buffer, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (buffer->len + len + 1 > buffer->size) {
+        buffer->size = (buffer->len + len + 1) * 2;
+        buffer->text = realloc(buffer->text, buffer->size);
+    }
+    va_start(args, fmt);
+    vsnprintf(buffer->text + buffer->len, len + 1, fmt, args);
+    va_end(args);
+    buffer->len += len;
+}
+
+// Many small siblings under the root, like a list or a grid of complications.
+static void prv_wide_child(struct Buffer *buffer, int n) {
+    if (n % 2) {
+        prv_append(buffer, "{\"id\":\"item%d\",\"type\":\"TextLayer\",\"frame\":[%d,%d,72,20],\"text\":\"%s\",\"color\":\"#FFFFFF\"}",
+            n, (n % 2) * 72, (n / 2 % 8) * 20, s_words[n % ARRAY_LENGTH(s_words)]);
+    } else {
+        prv_append(buffer, "{\"id\":\"item%d\",\"frame\":[%d,%d,72,20]}", n, (n % 2) * 72, (n / 2 % 8) * 20);
+    }
+}
+
+// Chains of nested groups, each with a label at the bottom.
+static void prv_deep_child(struct Buffer *buffer, int n) {
+    for (int depth = 0; depth < BENCH_DEPTH; depth++) {
+        prv_append(buffer, "{\"frame\":[1,1,%d,%d],\"layers\":[", 144 - depth * 2, 168 - depth * 2);
+    }
+    prv_append(buffer, "{\"id\":\"leaf%d\",\"type\":\"TextLayer\",\"frame\":[0,0,100,20],\"text\":\"%s\"}", n, s_words[n % ARRAY_LENGTH(s_words)]);
+    for (int depth = 0; depth < BENCH_DEPTH; depth++) {
+        prv_append(buffer, "]}");
+    }
+}
+
+// Text layers with long strings and every text property set.
+static void prv_text_child(struct Buffer *buffer, int n) {
+    prv_append(buffer, "{\"id\":\"text%d\",\"type\":\"TextLayer\",\"frame\":[0,%d,144,60],\"font\":\"GOTHIC_18\","
+        "\"alignment\":\"GTextAlignmentCenter\",\"overflow\":\"GTextOverflowModeWordWrap\",\"color\":\"#000000\","
+        "\"background\":\"#FFFFFF\",\"text\":\"", n, (n % 3) * 56);
+    for (int i = 0; i < 24; i++) {
+        prv_append(buffer, "%s%s", i ? " " : "", s_words[(n + i * 7) % ARRAY_LENGTH(s_words)]);
+    }
+    prv_append(buffer, "\"}");
+}
+
+// Bitmap layers sharing a handful of resources, like icon rows.
+static void prv_bitmap_child(struct Buffer *buffer, int n) {
+    prv_append(buffer, "{\"id\":\"icon%d\",\"type\":\"BitmapLayer\",\"frame\":[%d,%d,24,24],\"bitmap\":\"ICON%d\","
+        "\"alignment\":\"GAlignCenter\",\"compositing\":\"GCompOpSet\"}", n, (n % 6) * 24, (n / 6 % 7) * 24,
+        n % BENCH_NUM_BITMAPS);
+}
+
+static const struct Shape s_shapes[] = {
+    { "wide", prv_wide_child },
+    { "deep", prv_deep_child },
+    { "text", prv_text_child },
+    { "bitmap", prv_bitmap_child }
+};
+
+// Adds children to a root layer until the document reaches the target size.
+static char *prv_generate(const struct Shape *shape, size_t target) {
+    struct Buffer buffer = { NULL, 0, 0 };
+    prv_append(&buffer, "{\"id\":\"root\",\"frame\":[0,0,144,168],\"layers\":[");
+    for (int n = 0; ; n++) {
+        size_t len = buffer.len;
+        if (n) prv_append(&buffer, ",");
+        shape->child(&buffer, n);
+        if (n && buffer.len + 2 > target) {
+            buffer.len = len;
+            break;
+        }
+    }
+    prv_append(&buffer, "]}");
+    return buffer.text;
+}
+
+static Layout *prv_create_layout(void) {
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_system_fonts(layout);
+    for (int i = 0; i < BENCH_NUM_BITMAPS; i++) {
+        char name[8];
+        snprintf(name, sizeof(name), "ICON%d", i);
+        layout_add_resource(layout, name, i + 1);
+    }
+    return layout;
+}
+
+static double prv_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void prv_run(const struct Shape *shape, size_t target, double seconds) {
+    char *text = prv_generate(shape, target);
+    size_t len = strlen(text);
+
+    // Count tokens and layers once, outside the timed loop.
+    Json *json = json_create(strdup(text));
+    int num_tokens = json_get_num_tokens(json);
+    json_destroy(json);
+    Layout *layout = prv_create_layout();
+    layout_parse_string(layout, strdup(text));
+    LayoutStats stats;
+    layout_get_stats(layout, &stats);
+    layout_destroy(layout);
+
+    // Each iteration is what an app pays to show a window: create, parse, destroy. The copy
+    // of the text is part of it, since layout_parse_string() takes ownership.
+    long iterations = 0;
+    double start = prv_now();
+    double elapsed = 0;
+    do {
+        for (int i = 0; i < 16; i++) {
+            layout = prv_create_layout();
+            layout_parse_string(layout, strdup(text));
+            layout_destroy(layout);
+        }
+        iterations += 16;
+        elapsed = prv_now() - start;
+    } while (elapsed < seconds);
+
+    double per_second = iterations / elapsed;
+    printf("%-7s %6d %7d %7d %12.0f %14.0f %10.1f\n", shape->name, (int) len, num_tokens, stats.num_layers,
+        per_second, per_second * num_tokens, elapsed * 1e9 / iterations / (stats.num_layers ? stats.num_layers : 1));
+    free(text);
+}
+
+int main(int argc, char **argv) {
+    double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+    const char *only = argc > 2 ? argv[2] : NULL;
+
+    printf("%-7s %6s %7s %7s %12s %14s %10s\n", "shape", "bytes", "tokens", "layers", "layouts/s", "tokens/s", "ns/layer");
+    for (size_t i = 0; i < ARRAY_LENGTH(s_shapes); i++) {
+        if (only && strcmp(only, s_shapes[i].name) != 0) continue;
+        for (size_t j = 0; j < ARRAY_LENGTH(s_sizes); j++) {
+            prv_run(&s_shapes[i], s_sizes[j], seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// A counting allocator for host builds with HOST_COUNT_ALLOCS, where pebble.h routes malloc,
+// calloc, realloc and free here. Besides counting, it replays every allocation on a model of
+// a first-fit heap with 8 byte headers, like the watch's, to see how much the heap would
+// have to grow for the live blocks to fit between the holes.
+
+typedef struct {
+    // Calls to malloc, calloc and realloc, and the bytes they asked for.
+    uint32_t calls;
+    size_t bytes;
+    // Bytes asked for and not yet freed, and the most there were at once.
+    size_t live_bytes;
+    size_t peak_live_bytes;
+    uint32_t live_blocks;
+    // The furthest the modelled heap reached, and how much of it was holes at that point.
+    size_t peak_heap_bytes;
+    size_t fragmentation_bytes;
+} HostAllocStats;
+
+void *host_malloc(size_t size);
+void *host_calloc(size_t count, size_t size);
+void *host_realloc(void *ptr, size_t size);
+void host_free(void *ptr);
+
+// Clears the counters, but not the model of the heap, so blocks still live keep their place.
+void host_alloc_reset(void);
+void host_alloc_get_stats(HostAllocStats *stats);
+// Bytes the modelled heap uses, headers included.
+size_t host_alloc_heap_used(void);
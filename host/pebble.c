@@ -0,0 +1,394 @@
+#include <malloc.h>
+#include <stdarg.h>
+#include <pebble.h>
+
+#define HOST_MAX_RESOURCES 256
+
+struct Layer {
+    GRect frame;
+    bool hidden;
+    bool clips;
+    Layer *parent;
+    // Linked both ways with a tail, so adding and removing children does not walk their siblings.
+    Layer *first_child;
+    Layer *last_child;
+    Layer *prev_sibling;
+    Layer *next_sibling;
+    LayerUpdateProc update_proc;
+    // Aligned like the SDK's layer data.
+    max_align_t data[];
+};
+
+struct TextLayer {
+    Layer *layer;
+    const char *text;
+    GFont font;
+    GColor background_color;
+    GColor text_color;
+    GTextAlignment text_alignment;
+    GTextOverflowMode overflow_mode;
+};
+
+struct BitmapLayer {
+    Layer *layer;
+    const GBitmap *bitmap;
+    GColor background_color;
+    GAlign alignment;
+    GCompOp compositing_mode;
+};
+
+struct GBitmap {
+    uint32_t resource_id;
+};
+
+struct FontInfo {
+    const char *key;
+};
+
+struct AppTimer {
+    AppTimerCallback callback;
+    void *data;
+    AppTimer *next;
+};
+
+struct Resource {
+    const void *data;
+    size_t size;
+};
+
+static struct Resource s_resources[HOST_MAX_RESOURCES];
+static AppTimer *s_timers;
+static struct FontInfo s_system_font;
+static AppLogLevel s_log_level = APP_LOG_LEVEL_DEBUG_VERBOSE;
+
+void host_log(AppLogLevel level, const char *fmt, ...) {
+    if (level > s_log_level) return;
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "[%d] ", level);
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+void host_set_log_level(AppLogLevel level) {
+    s_log_level = level;
+}
+
+bool grect_equal(const GRect *a, const GRect *b) {
+    return a->origin.x == b->origin.x && a->origin.y == b->origin.y && gsize_equal(&a->size, &b->size);
+}
+
+bool gsize_equal(const GSize *a, const GSize *b) {
+    return a->w == b->w && a->h == b->h;
+}
+
+bool gcolor_equal(GColor a, GColor b) {
+    return a.argb == b.argb;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+}
+
+Layer *layer_create(GRect frame) {
+    return layer_create_with_data(frame, 0);
+}
+
+Layer *layer_create_with_data(GRect frame, size_t data_size) {
+    Layer *layer = calloc(1, sizeof(Layer) + data_size);
+    layer->frame = frame;
+    return layer;
+}
+
+void *layer_get_data(const Layer *layer) {
+    return (void *) layer->data;
+}
+
+void layer_destroy(Layer *layer) {
+    if (!layer) return;
+    layer_remove_from_parent(layer);
+    while (layer->first_child) layer_remove_from_parent(layer->first_child);
+    free(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer *layer, GRect frame) {
+    layer->frame = frame;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer->frame;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return GRect(0, 0, layer->frame.size.w, layer->frame.size.h);
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+    layer_remove_from_parent(child);
+    child->prev_sibling = parent->last_child;
+    if (parent->last_child) {
+        parent->last_child->next_sibling = child;
+    } else {
+        parent->first_child = child;
+    }
+    parent->last_child = child;
+    child->parent = parent;
+}
+
+void layer_remove_from_parent(Layer *child) {
+    Layer *parent = child->parent;
+    if (!parent) return;
+    if (child->prev_sibling) {
+        child->prev_sibling->next_sibling = child->next_sibling;
+    } else {
+        parent->first_child = child->next_sibling;
+    }
+    if (child->next_sibling) {
+        child->next_sibling->prev_sibling = child->prev_sibling;
+    } else {
+        parent->last_child = child->prev_sibling;
+    }
+    child->parent = NULL;
+    child->prev_sibling = NULL;
+    child->next_sibling = NULL;
+}
+
+void layer_insert_above_sibling(Layer *layer, Layer *sibling) {
+    layer_remove_from_parent(layer);
+    layer->parent = sibling->parent;
+    layer->prev_sibling = sibling;
+    layer->next_sibling = sibling->next_sibling;
+    if (sibling->next_sibling) {
+        sibling->next_sibling->prev_sibling = layer;
+    } else if (sibling->parent) {
+        sibling->parent->last_child = layer;
+    }
+    sibling->next_sibling = layer;
+}
+
+void layer_set_clips(Layer *layer, bool clips) {
+    layer->clips = clips;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+    layer->hidden = hidden;
+}
+
+bool layer_get_hidden(const Layer *layer) {
+    return layer->hidden;
+}
+
+void layer_mark_dirty(Layer *layer) {
+}
+
+Layer *layer_get_parent(const Layer *layer) {
+    return layer->parent;
+}
+
+TextLayer *text_layer_create(GRect frame) {
+    TextLayer *text_layer = calloc(1, sizeof(TextLayer));
+    text_layer->layer = layer_create(frame);
+    // The SDK's defaults.
+    text_layer->font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    text_layer->background_color = GColorWhite;
+    text_layer->text_color = GColorBlack;
+    text_layer->overflow_mode = GTextOverflowModeWordWrap;
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+    layer_destroy(text_layer->layer);
+    free(text_layer);
+}
+
+Layer *text_layer_get_layer(TextLayer *text_layer) {
+    return text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+    text_layer->text = text;
+}
+
+const char *text_layer_get_text(TextLayer *text_layer) {
+    return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+    text_layer->background_color = color;
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+    text_layer->text_color = color;
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+    text_layer->text_alignment = text_alignment;
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode overflow_mode) {
+    text_layer->overflow_mode = overflow_mode;
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+    text_layer->font = font;
+}
+
+GColor host_text_layer_get_text_color(TextLayer *text_layer) {
+    return text_layer->text_color;
+}
+
+GColor host_text_layer_get_background_color(TextLayer *text_layer) {
+    return text_layer->background_color;
+}
+
+GTextAlignment host_text_layer_get_alignment(TextLayer *text_layer) {
+    return text_layer->text_alignment;
+}
+
+GFont host_text_layer_get_font(TextLayer *text_layer) {
+    return text_layer->font;
+}
+
+GBitmap *gbitmap_create_with_resource(uint32_t resource_id) {
+    GBitmap *bitmap = malloc(sizeof(GBitmap));
+    bitmap->resource_id = resource_id;
+    return bitmap;
+}
+
+void gbitmap_destroy(GBitmap *bitmap) {
+    free(bitmap);
+}
+
+BitmapLayer *bitmap_layer_create(GRect frame) {
+    BitmapLayer *bitmap_layer = calloc(1, sizeof(BitmapLayer));
+    bitmap_layer->layer = layer_create(frame);
+    return bitmap_layer;
+}
+
+void bitmap_layer_destroy(BitmapLayer *bitmap_layer) {
+    layer_destroy(bitmap_layer->layer);
+    free(bitmap_layer);
+}
+
+Layer *bitmap_layer_get_layer(const BitmapLayer *bitmap_layer) {
+    return bitmap_layer->layer;
+}
+
+const GBitmap *bitmap_layer_get_bitmap(BitmapLayer *bitmap_layer) {
+    return bitmap_layer->bitmap;
+}
+
+void bitmap_layer_set_bitmap(BitmapLayer *bitmap_layer, const GBitmap *bitmap) {
+    bitmap_layer->bitmap = bitmap;
+}
+
+void bitmap_layer_set_background_color(BitmapLayer *bitmap_layer, GColor color) {
+    bitmap_layer->background_color = color;
+}
+
+void bitmap_layer_set_alignment(BitmapLayer *bitmap_layer, GAlign alignment) {
+    bitmap_layer->alignment = alignment;
+}
+
+void bitmap_layer_set_compositing_mode(BitmapLayer *bitmap_layer, GCompOp mode) {
+    bitmap_layer->compositing_mode = mode;
+}
+
+void host_resource_set(uint32_t resource_id, const void *data, size_t size) {
+    if (resource_id >= HOST_MAX_RESOURCES) return;
+    s_resources[resource_id].data = data;
+    s_resources[resource_id].size = size;
+}
+
+ResHandle resource_get_handle(uint32_t resource_id) {
+    if (resource_id >= HOST_MAX_RESOURCES) return NULL;
+    return &s_resources[resource_id];
+}
+
+size_t resource_size(ResHandle h) {
+    return h ? ((const struct Resource *) h)->size : 0;
+}
+
+size_t resource_load(ResHandle h, uint8_t *buffer, size_t max_length) {
+    return resource_load_byte_range(h, 0, buffer, max_length);
+}
+
+size_t resource_load_byte_range(ResHandle h, uint32_t start_offset, uint8_t *buffer, size_t num_bytes) {
+    size_t size = resource_size(h);
+    if (start_offset >= size) return 0;
+    if (num_bytes > size - start_offset) num_bytes = size - start_offset;
+    memcpy(buffer, (const uint8_t *) ((const struct Resource *) h)->data + start_offset, num_bytes);
+    return num_bytes;
+}
+
+GFont fonts_get_system_font(const char *font_key) {
+    s_system_font.key = font_key;
+    return &s_system_font;
+}
+
+GFont fonts_load_custom_font(ResHandle handle) {
+    GFont font = malloc(sizeof(FontInfo));
+    font->key = NULL;
+    return font;
+}
+
+void fonts_unload_custom_font(GFont font) {
+    free(font);
+}
+
+// glibc's view of the heap, or the counting allocator's model of the watch's; both include
+// the allocator's own overhead.
+size_t heap_bytes_used(void) {
+#ifdef HOST_COUNT_ALLOCS
+    return host_alloc_heap_used();
+#else
+    return mallinfo2().uordblks;
+#endif
+}
+
+size_t heap_bytes_free(void) {
+    return mallinfo2().fordblks;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint16_t ms = now.tv_nsec / 1000000;
+    if (t_utc) *t_utc = now.tv_sec;
+    if (out_ms) *out_ms = ms;
+    return ms;
+}
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    AppTimer *timer = malloc(sizeof(AppTimer));
+    timer->callback = callback;
+    timer->data = callback_data;
+    timer->next = s_timers;
+    s_timers = timer;
+    return timer;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+    for (AppTimer **link = &s_timers; *link; link = &(*link)->next) {
+        if (*link != timer) continue;
+        *link = timer->next;
+        free(timer);
+        return;
+    }
+}
+
+void host_run_timers(void) {
+    while (s_timers) {
+        AppTimer *timer = s_timers;
+        s_timers = timer->next;
+        timer->callback(timer->data);
+        free(timer);
+    }
+}
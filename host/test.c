@@ -0,0 +1,138 @@
+#include "test.h"
+
+// Runs the feature tests against the library built for this machine.
+// Usage: test <generated files directory> [suite]
+
+struct Suite {
+    const char *name;
+    const struct Test *tests;
+};
+
+static const struct Suite s_suites[] = {
+    { "conditions", test_conditions },
+    { "update", test_update },
+    { "lazy", test_lazy },
+    { "bindings", test_bindings },
+    { "frames", test_frames },
+    { "stream", test_stream },
+    { "binary", test_binary },
+    { "templates", test_templates },
+    { NULL }
+};
+
+static const char *s_data_dir;
+static const char *s_suite;
+static const char *s_test;
+static int s_failures;
+static char *s_resource_file;
+
+bool test_check(bool ok, const char *expr, const char *file, int line) {
+    if (ok) return true;
+    fprintf(stderr, "%s:%d: %s/%s: %s\n", file, line, s_suite, s_test, expr);
+    s_failures++;
+    return false;
+}
+
+bool test_check_int(int actual, int expected, const char *expr, const char *file, int line) {
+    if (actual == expected) return true;
+    fprintf(stderr, "%s:%d: %s/%s: %s is %d, expected %d\n", file, line, s_suite, s_test, expr, actual, expected);
+    s_failures++;
+    return false;
+}
+
+bool test_check_str(const char *actual, const char *expected, const char *expr, const char *file, int line) {
+    if (actual == expected || (actual && expected && strcmp(actual, expected) == 0)) return true;
+    fprintf(stderr, "%s:%d: %s/%s: %s is \"%s\", expected \"%s\"\n", file, line, s_suite, s_test, expr,
+        actual ? actual : "(null)", expected ? expected : "(null)");
+    s_failures++;
+    return false;
+}
+
+bool test_check_rect(GRect actual, GRect expected, const char *expr, const char *file, int line) {
+    if (grect_equal(&actual, &expected)) return true;
+    fprintf(stderr, "%s:%d: %s/%s: %s is [%d, %d, %d, %d], expected [%d, %d, %d, %d]\n", file, line, s_suite,
+        s_test, expr, actual.origin.x, actual.origin.y, actual.size.w, actual.size.h, expected.origin.x,
+        expected.origin.y, expected.size.w, expected.size.h);
+    s_failures++;
+    return false;
+}
+
+bool test_set_resource_file(uint32_t resource_id, const char *name) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", s_data_dir, name);
+    FILE *file = fopen(path, "rb");
+    if (!test_check(file != NULL, path, __FILE__, __LINE__)) return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    free(s_resource_file);
+    s_resource_file = malloc(size);
+    size_t read = fread(s_resource_file, 1, size, file);
+    fclose(file);
+    host_resource_set(resource_id, s_resource_file, read);
+    return true;
+}
+
+void test_set_resource(uint32_t resource_id, const char *text) {
+    host_resource_set(resource_id, text, strlen(text));
+}
+
+Layout *test_layout_create(void) {
+    Layout *layout = layout_create();
+    layout_add_all_standard_types(layout);
+    layout_add_system_fonts(layout);
+    layout_add_resource(layout, "ICON", TEST_RESOURCE_ICON);
+    return layout;
+}
+
+Layout *test_layout_parse(const char *json) {
+    Layout *layout = test_layout_create();
+    layout_parse_string(layout, strdup(json));
+    return layout;
+}
+
+Layer *test_layer(Layout *layout, char *id) {
+    return layout_get_layer(layout, layout_get_handle(layout, id));
+}
+
+GRect test_frame(Layout *layout, char *id) {
+    Layer *layer = test_layer(layout, id);
+    return layer ? layer_get_frame(layer) : GRectZero;
+}
+
+static void prv_run_suite(const struct Suite *suite) {
+    s_suite = suite->name;
+    for (const struct Test *test = suite->tests; test->name; test++) {
+        s_test = test->name;
+        int failures = s_failures;
+        test->run();
+        // Leftover redraws belong to the test that scheduled them.
+        host_run_timers();
+        host_set_log_level(APP_LOG_LEVEL_DEBUG_VERBOSE);
+        printf("%-10s %-32s %s\n", suite->name, test->name, s_failures == failures ? "ok" : "FAILED");
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <generated files directory> [suite]\n", argv[0]);
+        return 2;
+    }
+    s_data_dir = argv[1];
+
+    bool found = false;
+    for (const struct Suite *suite = s_suites; suite->name; suite++) {
+        if (argc > 2 && strcmp(argv[2], suite->name) != 0) continue;
+        prv_run_suite(suite);
+        found = true;
+    }
+    free(s_resource_file);
+    if (argc > 2 && !found) {
+        fprintf(stderr, "no suite called %s\n", argv[2]);
+        return 2;
+    }
+
+    if (s_failures) printf("%d checks failed\n", s_failures);
+    else printf("all tests passed\n");
+    return s_failures ? 1 : 0;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <pebble.h>
+#include "pebble-layout.h"
+
+// Assertions for the feature tests in tests/. A failed check is reported with its file and line
+// and the test carries on, so one run shows every failure.
+
+#define check(expr) test_check((expr), #expr, __FILE__, __LINE__)
+#define check_int(actual, expected) test_check_int((actual), (expected), #actual, __FILE__, __LINE__)
+#define check_str(actual, expected) test_check_str((actual), (expected), #actual, __FILE__, __LINE__)
+#define check_rect(actual, x, y, w, h) test_check_rect((actual), GRect(x, y, w, h), #actual, __FILE__, __LINE__)
+
+typedef void (*TestFunc)(void);
+
+struct Test {
+    const char *name;
+    TestFunc run;
+};
+
+bool test_check(bool ok, const char *expr, const char *file, int line);
+bool test_check_int(int actual, int expected, const char *expr, const char *file, int line);
+bool test_check_str(const char *actual, const char *expected, const char *expr, const char *file, int line);
+bool test_check_rect(GRect actual, GRect expected, const char *expr, const char *file, int line);
+
+// Resource ids the tests can give contents with test_set_resource(); TEST_RESOURCE_ICON is
+// registered as the bitmap "ICON" in every test layout.
+enum {
+    TEST_RESOURCE_ICON = 1,
+    TEST_RESOURCE_LAYOUT
+};
+
+// Points a resource at a copy of a file the Makefile generated, such as a compiled binary
+// layout. The copy stays valid until the next call.
+bool test_set_resource_file(uint32_t resource_id, const char *name);
+// Points a resource at a string, which must outlive its use.
+void test_set_resource(uint32_t resource_id, const char *text);
+
+// A layout with the standard types, the system fonts and the bitmap "ICON", ready to parse.
+Layout *test_layout_create(void);
+// The same, with json parsed from a copy of the string.
+Layout *test_layout_parse(const char *json);
+// The layer of the layout's layer with an id, or NULL.
+Layer *test_layer(Layout *layout, char *id);
+GRect test_frame(Layout *layout, char *id);
+
+extern const struct Test test_conditions[];
+extern const struct Test test_update[];
+extern const struct Test test_lazy[];
+extern const struct Test test_bindings[];
+extern const struct Test test_frames[];
+extern const struct Test test_stream[];
+extern const struct Test test_binary[];
+extern const struct Test test_templates[];
@@ -0,0 +1,71 @@
+#include "test.h"
+
+// tests/layouts/binary.json, compiled by tools/layout_compiler.py into the data directory.
+
+static Layout *prv_load(void) {
+    if (!test_set_resource_file(TEST_RESOURCE_LAYOUT, "binary.bin")) return NULL;
+    Layout *layout = test_layout_create();
+    layout_parse_binary(layout, TEST_RESOURCE_LAYOUT);
+    return layout;
+}
+
+static void prv_layers(void) {
+    Layout *layout = prv_load();
+    if (!layout) return;
+    Layer *root = layout_get_root_layer(layout);
+    check(root != NULL);
+    check_rect(test_frame(layout, "root"), 0, 0, 144, 168);
+    check_rect(test_frame(layout, "title"), 0, 10, 144, 30);
+    check_rect(test_frame(layout, "group"), 10, 50, 124, 100);
+    check(layer_get_parent(test_layer(layout, "title")) == root);
+    check(layer_get_parent(test_layer(layout, "icon")) == test_layer(layout, "group"));
+    check(layer_get_parent(test_layer(layout, "title2")) == test_layer(layout, "group"));
+    layout_destroy(layout);
+}
+
+static void prv_properties(void) {
+    Layout *layout = prv_load();
+    if (!layout) return;
+    TextLayer *title = layout_find_by_id(layout, "title");
+    check(title != NULL);
+    if (title) {
+        check_str(text_layer_get_text(title), "Binary");
+        check_int(host_text_layer_get_text_color(title).argb, GColorWhite.argb);
+        check_int(host_text_layer_get_background_color(title).argb, GColorFromHEX(0x0000FF).argb);
+        check_int(host_text_layer_get_alignment(title), GTextAlignmentCenter);
+        check(host_text_layer_get_font(title) != NULL);
+    }
+    // Only enum properties turn enum names into numbers.
+    TextLayer *title2 = layout_find_by_id(layout, "title2");
+    if (check(title2 != NULL)) {
+        check_str(text_layer_get_text(title2), "GTextAlignmentCenter");
+        check_int(host_text_layer_get_alignment(title2), GTextAlignmentRight);
+    }
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    check(icon != NULL && bitmap_layer_get_bitmap(icon) != NULL);
+    layout_destroy(layout);
+}
+
+static void prv_truncated(void) {
+    if (!test_set_resource_file(TEST_RESOURCE_LAYOUT, "binary.bin")) return;
+    ResHandle handle = resource_get_handle(TEST_RESOURCE_LAYOUT);
+    size_t size = resource_size(handle);
+    uint8_t *data = malloc(size);
+    resource_load(handle, data, size);
+    host_set_log_level(0);
+    // Cut short anywhere, the layout loads what it can or nothing, without reading past the end.
+    for (size_t len = 0; len < size; len += 7) {
+        host_resource_set(TEST_RESOURCE_LAYOUT, data, len);
+        Layout *layout = test_layout_create();
+        layout_parse_binary(layout, TEST_RESOURCE_LAYOUT);
+        layout_destroy(layout);
+    }
+    free(data);
+}
+
+const struct Test test_binary[] = {
+    { "layers", prv_layers },
+    { "properties", prv_properties },
+    { "truncated", prv_truncated },
+    { NULL }
+};
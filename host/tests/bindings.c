@@ -0,0 +1,82 @@
+#include "test.h"
+
+static const char *s_layout = "{\"layers\": ["
+    "{\"id\": \"a\", \"type\": \"TextLayer\", \"text\": \"{steps}\", \"color\": \"{color}\"},"
+    "{\"id\": \"b\", \"type\": \"TextLayer\", \"text\": \"{steps:4}\", \"alignment\": \"{align}\"},"
+    "{\"id\": \"c\", \"type\": \"TextLayer\", \"text\": \"{not bound}\"},"
+    "{\"id\": \"icon\", \"type\": \"BitmapLayer\", \"bitmap\": \"{icon}\"}]}";
+
+static void prv_values_applied_on_flush(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    TextLayer *a = layout_find_by_id(layout, "a");
+    TextLayer *b = layout_find_by_id(layout, "b");
+    check_str(text_layer_get_text(a), "");
+    check_int(host_text_layer_get_text_color(a).argb, GColorBlack.argb);
+
+    layout_set_value_int(layout, "steps", 1234567);
+    layout_set_value_int(layout, "steps", 42);
+    layout_set_value(layout, "color", "#FF0000");
+    layout_set_value(layout, "align", "GTextAlignmentRight");
+    check_int(host_text_layer_get_text_color(a).argb, GColorBlack.argb);
+    host_run_timers();
+    check_str(text_layer_get_text(a), "42");
+    check_str(text_layer_get_text(b), "42");
+    check_int(host_text_layer_get_text_color(a).argb, GColorFromHEX(0xFF0000).argb);
+    check_int(host_text_layer_get_alignment(b), GTextAlignmentRight);
+    layout_destroy(layout);
+}
+
+static void prv_strings_share_buffer(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    TextLayer *a = layout_find_by_id(layout, "a");
+    TextLayer *b = layout_find_by_id(layout, "b");
+    // Both point at the binding's buffer, which the larger size of the two declares.
+    check(text_layer_get_text(a) == text_layer_get_text(b));
+    layout_set_value(layout, "steps", "0123456789012345678901234567890123456789");
+    host_run_timers();
+    check_str(text_layer_get_text(a), "0123456789012345678901234567890");
+    layout_destroy(layout);
+}
+
+static void prv_not_a_placeholder(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    check_str(text_layer_get_text(layout_find_by_id(layout, "c")), "{not bound}");
+    layout_destroy(layout);
+}
+
+static void prv_resources(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    check(bitmap_layer_get_bitmap(icon) == NULL);
+    layout_set_value(layout, "icon", "ICON");
+    host_run_timers();
+    check(bitmap_layer_get_bitmap(icon) != NULL);
+    layout_destroy(layout);
+}
+
+static void prv_update_rebinds(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    layout_set_value(layout, "steps", "7");
+    host_run_timers();
+    layout_update_string(layout, strdup("{\"layers\": ["
+        "{\"id\": \"a\", \"type\": \"TextLayer\", \"text\": \"fixed\"},"
+        "{\"id\": \"d\", \"type\": \"TextLayer\", \"text\": \"{steps}\"}]}"));
+    TextLayer *a = layout_find_by_id(layout, "a");
+    TextLayer *d = layout_find_by_id(layout, "d");
+    check_str(text_layer_get_text(a), "fixed");
+    check_str(text_layer_get_text(d), "7");
+    layout_set_value(layout, "steps", "8");
+    host_run_timers();
+    check_str(text_layer_get_text(a), "fixed");
+    check_str(text_layer_get_text(d), "8");
+    layout_destroy(layout);
+}
+
+const struct Test test_bindings[] = {
+    { "values applied on flush", prv_values_applied_on_flush },
+    { "strings share buffer", prv_strings_share_buffer },
+    { "not a placeholder", prv_not_a_placeholder },
+    { "resources", prv_resources },
+    { "update rebinds", prv_update_rebinds },
+    { NULL }
+};
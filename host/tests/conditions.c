@@ -0,0 +1,71 @@
+#include "test.h"
+
+// The stand-in pebble.h is a 144x168 basalt: rect and color.
+
+static void prv_member_conditions(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\", \"layers\": ["
+        "{\"id\": \"a\", \"frame@round\": [1, 1, 1, 1], \"frame\": [2, 2, 2, 2]},"
+        "{\"id\": \"b\", \"frame\": [2, 2, 2, 2], \"frame@rect\": [3, 3, 3, 3]},"
+        "{\"id\": \"c\", \"frame@!color\": [4, 4, 4, 4], \"frame\": [5, 5, 5, 5]},"
+        "{\"id\": \"d\", \"frame@144x168\": [6, 6, 6, 6]},"
+        "{\"id\": \"e\", \"frame@basalt\": [7, 7, 7, 7], \"frame@!basalt\": [8, 8, 8, 8]}]}");
+    check_rect(test_frame(layout, "a"), 2, 2, 2, 2);
+    check_rect(test_frame(layout, "b"), 3, 3, 3, 3);
+    check_rect(test_frame(layout, "c"), 5, 5, 5, 5);
+    check_rect(test_frame(layout, "d"), 6, 6, 6, 6);
+    check_rect(test_frame(layout, "e"), 7, 7, 7, 7);
+    layout_destroy(layout);
+}
+
+static void prv_if_objects(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\", \"layers\": ["
+        "{\"if\": \"round\", \"id\": \"round\", \"layers\": [{\"id\": \"inside\"}]},"
+        "{\"if\": \"color\", \"id\": \"color\"},"
+        "{\"if\": \"200x228\", \"id\": \"emery\"},"
+        "{\"id\": \"plain\"}]}");
+    check(layout_find_by_id(layout, "round") == NULL);
+    check(layout_find_by_id(layout, "inside") == NULL);
+    check(layout_find_by_id(layout, "color") != NULL);
+    check(layout_find_by_id(layout, "emery") == NULL);
+    check(layout_find_by_id(layout, "plain") != NULL);
+    check(layer_get_parent(test_layer(layout, "plain")) == layout_get_root_layer(layout));
+    layout_destroy(layout);
+}
+
+// Conditional members apply to properties from the type's schema too, not just the frame.
+static void prv_property_conditions(void) {
+    Layout *layout = test_layout_parse("{\"layers\": [{\"id\": \"text\", \"type\": \"TextLayer\","
+        "\"text@bw\": \"mono\", \"text\": \"plain\", \"color@color\": \"#FF0000\"}]}");
+    TextLayer *text = layout_find_by_id(layout, "text");
+    check_str(text_layer_get_text(text), "plain");
+    check_int(host_text_layer_get_text_color(text).argb, GColorFromHEX(0xFF0000).argb);
+    layout_destroy(layout);
+}
+
+static void prv_update_conditions(void) {
+    Layout *layout = test_layout_parse("{\"layers\": [{\"id\": \"a\", \"frame\": [1, 1, 1, 1]}]}");
+    layout_update_string(layout, strdup("{\"layers\": [{\"id\": \"a\", \"frame\": [1, 1, 1, 1], \"frame@rect\": [9, 9, 9, 9]},"
+        "{\"if\": \"!rect\", \"id\": \"b\"}]}"));
+    check_rect(test_frame(layout, "a"), 9, 9, 9, 9);
+    check(layout_find_by_id(layout, "b") == NULL);
+    layout_destroy(layout);
+}
+
+// Only member names are conditions; text that merely looks like one stays as written.
+static void prv_condition_text(void) {
+    Layout *layout = test_layout_parse("{\"layers\": [{\"id\": \"a\", \"type\": \"TextLayer\","
+        "\"text\": \"me@rect \\\": \\\"if\"}, {\"id\": \"b\", \"frame\": [1, 1, 1, 1], \"frame@rect\": [2, 2, 2, 2]}]}");
+    TextLayer *a = layout_find_by_id(layout, "a");
+    if (check(a != NULL)) check_str(text_layer_get_text(a), "me@rect \\\": \\\"if");
+    check_rect(test_frame(layout, "b"), 2, 2, 2, 2);
+    layout_destroy(layout);
+}
+
+const struct Test test_conditions[] = {
+    { "member conditions", prv_member_conditions },
+    { "if objects", prv_if_objects },
+    { "property conditions", prv_property_conditions },
+    { "update conditions", prv_update_conditions },
+    { "condition text", prv_condition_text },
+    { NULL }
+};
@@ -0,0 +1,91 @@
+#include "test.h"
+
+static const char *s_layout = "{\"id\": \"root\", \"layers\": ["
+    "{\"id\": \"title\", \"frame\": [0, 4, \"100%\", 30], \"anchor\": \"top\"},"
+    "{\"id\": \"column\", \"stack\": \"vertical\", \"spacing\": 2, \"frame\": [\"10%\", 40, \"80%\", \"50%\"], \"layers\": ["
+        "{\"id\": \"a\", \"frame\": [0, 0, \"100%\", 20]},"
+        "{\"id\": \"b\", \"frame\": [0, 0, \"50%\", 10], \"anchor\": \"right\"},"
+        "{\"id\": \"c\", \"frame\": [0, 3, 20, \"20%\"]}]},"
+    "{\"id\": \"badge\", \"frame\": [-4, -4, 20, 20], \"anchor\": \"bottom-right\"},"
+    "{\"id\": \"row\", \"stack\": \"horizontal\", \"frame\": [0, 140, 144, 20], \"layers\": ["
+        "{\"id\": \"left\", \"frame\": [0, 0, \"25%\", 20]},"
+        "{\"id\": \"right\", \"frame\": [4, 0, \"25%+2\", 20]}]},"
+    "{\"id\": \"absolute\", \"frame\": [1, 2, 3, 4]}]}";
+
+static void prv_relative_frames(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    check_rect(test_frame(layout, "root"), 0, 0, 144, 168);
+    check_rect(test_frame(layout, "title"), 0, 4, 144, 30);
+    check_rect(test_frame(layout, "column"), 14, 40, 115, 84);
+    check_rect(test_frame(layout, "badge"), 120, 144, 20, 20);
+    check_rect(test_frame(layout, "absolute"), 1, 2, 3, 4);
+    layout_destroy(layout);
+}
+
+static void prv_stacks(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    check_rect(test_frame(layout, "a"), 0, 0, 115, 20);
+    check_rect(test_frame(layout, "b"), 58, 22, 57, 10);
+    check_rect(test_frame(layout, "c"), 0, 37, 20, 16);
+    check_rect(test_frame(layout, "left"), 0, 0, 36, 20);
+    check_rect(test_frame(layout, "right"), 40, 0, 38, 20);
+    layout_destroy(layout);
+}
+
+static void prv_set_frame(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    // Growing a stacked layer moves the ones after it.
+    layout_set_frame(layout, "a", "0, 0, 100%, 40");
+    check_rect(test_frame(layout, "a"), 0, 0, 115, 40);
+    check_rect(test_frame(layout, "b"), 58, 42, 57, 10);
+    check_rect(test_frame(layout, "c"), 0, 57, 20, 16);
+    // Resizing a parent resizes the relative children below it.
+    layout_set_frame(layout, "column", "0, 40, 100%, 50%");
+    check_rect(test_frame(layout, "column"), 0, 40, 144, 84);
+    check_rect(test_frame(layout, "a"), 0, 0, 144, 40);
+    check_rect(test_frame(layout, "b"), 72, 42, 72, 10);
+    // A layer with a plain frame can only be given another plain frame.
+    host_set_log_level(0);
+    layout_set_frame(layout, "absolute", "5, 6, 50%, 8");
+    check_rect(test_frame(layout, "absolute"), 5, 6, 0, 8);
+    layout_destroy(layout);
+}
+
+static void prv_relative_root(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\", \"frame\": [\"10%\", 0, \"50%\", \"100%-8\"],"
+        "\"layers\": [{\"id\": \"half\", \"frame\": [0, 0, \"50%\", \"50%\"]}]}");
+    check_rect(test_frame(layout, "root"), 14, 0, 72, 160);
+    check_rect(test_frame(layout, "half"), 0, 0, 36, 80);
+    layout_destroy(layout);
+}
+
+// Applying the same document again leaves everything where it was.
+static void prv_update_keeps_frames(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    layout_update_string(layout, strdup(s_layout));
+    check_rect(test_frame(layout, "title"), 0, 4, 144, 30);
+    check_rect(test_frame(layout, "column"), 14, 40, 115, 84);
+    check_rect(test_frame(layout, "badge"), 120, 144, 20, 20);
+    check_rect(test_frame(layout, "b"), 58, 22, 57, 10);
+    check_rect(test_frame(layout, "c"), 0, 37, 20, 16);
+    check_rect(test_frame(layout, "right"), 40, 0, 38, 20);
+    check_rect(test_frame(layout, "absolute"), 1, 2, 3, 4);
+    // A changed frame in the new document moves the stacked layers after it.
+    layout_update_string(layout, strdup("{\"id\": \"root\", \"layers\": ["
+        "{\"id\": \"column\", \"stack\": \"vertical\", \"frame\": [0, 0, \"50%\", \"100%\"], \"layers\": ["
+            "{\"id\": \"a\", \"frame\": [0, 0, \"100%\", 30]},"
+            "{\"id\": \"c\", \"frame\": [0, 3, 20, \"20%\"]}]}]}"));
+    check_rect(test_frame(layout, "column"), 0, 0, 72, 168);
+    check_rect(test_frame(layout, "a"), 0, 0, 72, 30);
+    check_rect(test_frame(layout, "c"), 0, 33, 20, 33);
+    layout_destroy(layout);
+}
+
+const struct Test test_frames[] = {
+    { "relative frames", prv_relative_frames },
+    { "stacks", prv_stacks },
+    { "set frame", prv_set_frame },
+    { "relative root", prv_relative_root },
+    { "update keeps frames", prv_update_keeps_frames },
+    { NULL }
+};
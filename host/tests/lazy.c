@@ -0,0 +1,150 @@
+#include "test.h"
+
+static const char *s_layout = "{\"id\": \"root\", \"layers\": ["
+    "{\"id\": \"first\"},"
+    "{\"id\": \"details\", \"lazy\": true, \"frame\": [1, 2, 100, 50], \"layers\": ["
+        "{\"id\": \"label\", \"type\": \"TextLayer\", \"text\": \"{label}\"},"
+        "{\"id\": \"icon\", \"type\": \"BitmapLayer\", \"bitmap\": \"ICON\"},"
+        "{\"id\": \"inner\", \"lazy\": true, \"layers\": [{\"id\": \"deep\"}]}]},"
+    "{\"id\": \"last\"}]}";
+
+static int prv_count_layers(Layout *layout) {
+    LayoutStats stats;
+    layout_get_stats(layout, &stats);
+    return stats.num_layers;
+}
+
+static void prv_not_created_until_shown(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    check(layout_find_by_id(layout, "details") == NULL);
+    check(layout_find_by_id(layout, "label") == NULL);
+    // The root, first, last and the placeholder for details.
+    check_int(prv_count_layers(layout), 4);
+
+    layout_show(layout, "details");
+    Layer *details = test_layer(layout, "details");
+    check(details != NULL);
+    check(layout_find_by_id(layout, "label") != NULL);
+    check(layout_find_by_id(layout, "deep") == NULL);
+    if (details) {
+        check(!layer_get_hidden(details));
+        check(layer_get_parent(details) == layout_get_root_layer(layout));
+        check_rect(layer_get_frame(details), 1, 2, 100, 50);
+    }
+
+    layout_show(layout, "inner");
+    check(layout_find_by_id(layout, "deep") != NULL);
+    check(layer_get_parent(test_layer(layout, "inner")) == details);
+    layout_destroy(layout);
+}
+
+static void prv_hide(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    layout_show(layout, "details");
+    void *label = layout_find_by_id(layout, "label");
+    layout_hide(layout, "details", false);
+    check(layer_get_hidden(test_layer(layout, "details")));
+    check(layout_find_by_id(layout, "label") == label);
+
+    layout_show(layout, "details");
+    check(!layer_get_hidden(test_layer(layout, "details")));
+    check(layout_find_by_id(layout, "label") == label);
+    layout_destroy(layout);
+}
+
+static void prv_hide_and_destroy(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    for (int i = 0; i < 3; i++) {
+        layout_show(layout, "details");
+        layout_show(layout, "inner");
+        check(layout_find_by_id(layout, "deep") != NULL);
+        layout_hide(layout, "details", true);
+        check(layout_find_by_id(layout, "details") == NULL);
+        check(layout_find_by_id(layout, "label") == NULL);
+        check(layout_find_by_id(layout, "inner") == NULL);
+        check(layout_find_by_id(layout, "deep") == NULL);
+        check(layout_find_by_id(layout, "first") != NULL);
+        check(layout_find_by_id(layout, "last") != NULL);
+        check_int(prv_count_layers(layout), 4);
+    }
+    layout_destroy(layout);
+}
+
+static void prv_bindings_inside(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    layout_show(layout, "details");
+    layout_set_value(layout, "label", "Shown");
+    host_run_timers();
+    TextLayer *label = layout_find_by_id(layout, "label");
+    check_str(text_layer_get_text(label), "Shown");
+
+    // Bindings hold on to their value while the layers showing it come and go.
+    layout_hide(layout, "details", true);
+    layout_set_value(layout, "label", "Again");
+    host_run_timers();
+    layout_show(layout, "details");
+    label = layout_find_by_id(layout, "label");
+    check_str(text_layer_get_text(label), "Again");
+    layout_destroy(layout);
+}
+
+// Once shown, lazy layers are laid out in their parent like their siblings were.
+static void prv_relative_frames(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\", \"layers\": ["
+        "{\"id\": \"box\", \"frame\": [0, 0, 60, 60], \"layers\": ["
+            "{\"id\": \"eager\", \"frame\": [0, 0, \"50%\", \"50%\"]},"
+            "{\"id\": \"lazy\", \"lazy\": true, \"frame\": [0, 0, \"50%\", \"50%\"]}]},"
+        "{\"id\": \"column\", \"stack\": \"vertical\", \"frame\": [0, 60, 100, 100], \"layers\": ["
+            "{\"id\": \"top\", \"frame\": [0, 0, \"100%\", 10]},"
+            "{\"id\": \"middle\", \"lazy\": true, \"frame\": [0, 0, \"50%\", 20]},"
+            "{\"id\": \"bottom\", \"frame\": [0, 0, \"100%\", 10]}]}]}");
+    check_rect(test_frame(layout, "eager"), 0, 0, 30, 30);
+    // The hidden slot takes no room.
+    check_rect(test_frame(layout, "bottom"), 0, 10, 100, 10);
+
+    layout_show(layout, "lazy");
+    check_rect(test_frame(layout, "lazy"), 0, 0, 30, 30);
+    layout_show(layout, "middle");
+    check_rect(test_frame(layout, "middle"), 0, 10, 50, 20);
+    check_rect(test_frame(layout, "bottom"), 0, 30, 100, 10);
+
+    layout_hide(layout, "middle", true);
+    layout_set_frame(layout, "top", "0, 0, 100%, 12");
+    check_rect(test_frame(layout, "bottom"), 0, 12, 100, 10);
+    layout_show(layout, "middle");
+    check_rect(test_frame(layout, "middle"), 0, 12, 50, 20);
+    check_rect(test_frame(layout, "bottom"), 0, 32, 100, 10);
+    layout_destroy(layout);
+}
+
+// Records, bindings, nested lazy layers and frames are used again on the next show.
+static void prv_cycles_keep_memory(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\", \"stack\": \"vertical\", \"layers\": ["
+        "{\"id\": \"details\", \"lazy\": true, \"frame\": [0, 0, \"100%\", \"50%\"], \"layers\": ["
+            "{\"id\": \"label\", \"type\": \"TextLayer\", \"frame\": [0, 0, \"100%\", 20], \"text\": \"{label}\"},"
+            "{\"id\": \"inner\", \"lazy\": true, \"layers\": [{\"id\": \"deep\"}]}]}]}");
+    LayoutStats before;
+    for (int i = 0; i < 40; i++) {
+        layout_show(layout, "details");
+        layout_show(layout, "inner");
+        layout_hide(layout, "details", true);
+        if (i == 0) layout_get_stats(layout, &before);
+    }
+    LayoutStats after;
+    layout_get_stats(layout, &after);
+    check_int(after.arena_bytes, before.arena_bytes);
+    check_int(after.num_layers, before.num_layers);
+    layout_show(layout, "details");
+    check_rect(test_frame(layout, "label"), 0, 0, 144, 20);
+    layout_destroy(layout);
+}
+
+const struct Test test_lazy[] = {
+    { "not created until shown", prv_not_created_until_shown },
+    { "hide", prv_hide },
+    { "hide and destroy", prv_hide_and_destroy },
+    { "bindings inside", prv_bindings_inside },
+    { "relative frames", prv_relative_frames },
+    { "cycles keep memory", prv_cycles_keep_memory },
+    { NULL }
+};
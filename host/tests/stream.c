@@ -0,0 +1,164 @@
+#include "test.h"
+
+static const char *s_layout = "{\"id\": \"root\", \"background\": \"#000000\", \"layers\": ["
+    "{\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": [0, 0, 144, 30], \"text\": \"Hello\","
+        "\"color\": \"#FFFFFF\", \"alignment\": \"GTextAlignmentCenter\", \"font\": \"GOTHIC_24_BOLD\"},"
+    "{\"id\": \"group\", \"frame\": [0, 30, 144, 100], \"unknown\": {\"skipped\": [1, {\"deep\": true}]}, \"layers\": ["
+        "{\"id\": \"icon\", \"type\": \"BitmapLayer\", \"frame\": [2, 2, 20, 20], \"bitmap\": \"ICON\"},"
+        "{\"id\": \"inner\", \"frame\": [30, 2, 40, 40], \"clips\": true}]}]}";
+
+static void prv_same_as_parse(void) {
+    test_set_resource(TEST_RESOURCE_LAYOUT, s_layout);
+    Layout *layout = test_layout_create();
+    layout_parse_stream(layout, TEST_RESOURCE_LAYOUT);
+    Layer *root = layout_get_root_layer(layout);
+    check(root != NULL);
+    check_rect(test_frame(layout, "root"), 0, 0, 144, 168);
+    TextLayer *title = layout_find_by_id(layout, "title");
+    check(title != NULL);
+    if (title) {
+        check_str(text_layer_get_text(title), "Hello");
+        check_int(host_text_layer_get_text_color(title).argb, GColorWhite.argb);
+        check_int(host_text_layer_get_alignment(title), GTextAlignmentCenter);
+        check_rect(layer_get_frame(text_layer_get_layer(title)), 0, 0, 144, 30);
+        check(layer_get_parent(text_layer_get_layer(title)) == root);
+    }
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    check(icon != NULL && bitmap_layer_get_bitmap(icon) != NULL);
+    check(layer_get_parent(test_layer(layout, "inner")) == test_layer(layout, "group"));
+    check_rect(test_frame(layout, "inner"), 30, 2, 40, 40);
+    layout_destroy(layout);
+}
+
+// Many layers, so the document is several times the size of the window.
+static void prv_larger_than_window(void) {
+    char *text = malloc(16384);
+    int len = sprintf(text, "{\"id\": \"root\", \"layers\": [");
+    for (int i = 0; i < 100; i++) {
+        len += sprintf(text + len, "%s{\"id\": \"item%d\", \"type\": \"TextLayer\", \"frame\": [%d, %d, 72, 20], \"text\": \"Item number %d\"}",
+            i ? ", " : "", i, i % 2 * 72, i / 2 * 20, i);
+    }
+    sprintf(text + len, "]}");
+    test_set_resource(TEST_RESOURCE_LAYOUT, text);
+
+    Layout *layout = test_layout_create();
+    layout_parse_stream(layout, TEST_RESOURCE_LAYOUT);
+    char id[16];
+    char expected[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(id, sizeof(id), "item%d", i);
+        snprintf(expected, sizeof(expected), "Item number %d", i);
+        TextLayer *item = layout_find_by_id(layout, id);
+        if (!check(item != NULL)) break;
+        check_str(text_layer_get_text(item), expected);
+        check_rect(test_frame(layout, id), i % 2 * 72, i / 2 * 20, 72, 20);
+    }
+    layout_destroy(layout);
+    free(text);
+}
+
+static void prv_escapes(void) {
+    test_set_resource(TEST_RESOURCE_LAYOUT, "{\"layers\": [{\"id\": \"quote\", \"type\": \"TextLayer\", \"text\": \"say \\\"hi\\\"\"}]}");
+    Layout *layout = test_layout_create();
+    layout_parse_stream(layout, TEST_RESOURCE_LAYOUT);
+    TextLayer *quote = layout_find_by_id(layout, "quote");
+    check(quote != NULL);
+    // Like layout_parse(), escapes are kept as written.
+    if (quote) check_str(text_layer_get_text(quote), "say \\\"hi\\\"");
+    layout_destroy(layout);
+}
+
+// The backslash of an escape lands on each position around the end of the first window.
+static void prv_escape_on_window_boundary(void) {
+    const char *prefix = "{\"layers\": [{\"id\": \"quote\", \"type\": \"TextLayer\", \"text\": \"";
+    char text[512];
+    char expected[512];
+    for (int boundary = 250; boundary < 262; boundary++) {
+        int len = sprintf(text, "%s", prefix);
+        while (len < boundary) text[len++] = 'a';
+        sprintf(text + len, "\\\"end\"}]}");
+        int start = strlen(prefix);
+        snprintf(expected, sizeof(expected), "%.*s\\\"end", len - start, text + start);
+        test_set_resource(TEST_RESOURCE_LAYOUT, text);
+
+        Layout *layout = test_layout_create();
+        layout_parse_stream(layout, TEST_RESOURCE_LAYOUT);
+        TextLayer *quote = layout_find_by_id(layout, "quote");
+        if (check(quote != NULL)) check_str(text_layer_get_text(quote), expected);
+        layout_destroy(layout);
+    }
+}
+
+static void prv_set_tag(Layout *layout, void *object, LayoutValue value) {
+    layer_set_frame((Layer *) object, GRect(0, 0, value.integer, value.integer));
+}
+
+static const LayoutProperty s_tagged_properties[] = {
+    { "a_property_named_with_31_chars_", LayoutPropertyInt, prv_set_tag, NULL },
+    { NULL }
+};
+
+static void *prv_tagged_create(Layout *layout, Json *json, JsonToken *token) {
+    return layer_create(GRectZero);
+}
+
+static void prv_tagged_destroy(void *object) {
+    layer_destroy((Layer *) object);
+}
+
+static Layer *prv_tagged_get_layer(void *object) {
+    return (Layer *) object;
+}
+
+static void prv_tagged_set_frame(void *object, GRect frame) {
+    layer_set_frame((Layer *) object, frame);
+}
+
+// A key is never cut short to the length of a property's name.
+static void prv_long_keys(void) {
+    test_set_resource(TEST_RESOURCE_LAYOUT, "{\"layers\": [{\"id\": \"tagged\", \"type\": \"Tagged\","
+        "\"frame\": [1, 2, 3, 4],"
+        "\"a_property_named_with_31_chars__and_more\": 5,"
+        "\"an_unknown_member_with_a_long_name\": {\"nested\": [1, 2]}}]}");
+    Layout *layout = test_layout_create();
+    layout_add_type(layout, "Tagged", (LayoutFuncs) {
+        .create = prv_tagged_create,
+        .destroy = prv_tagged_destroy,
+        .get_layer = prv_tagged_get_layer,
+        .set_frame = prv_tagged_set_frame,
+        .properties = s_tagged_properties
+    });
+    layout_parse_stream(layout, TEST_RESOURCE_LAYOUT);
+    check_rect(test_frame(layout, "tagged"), 1, 2, 3, 4);
+    layout_destroy(layout);
+}
+
+// Members that need the whole document are reported and left out, and the rest is read as usual.
+static void prv_unsupported_members(void) {
+    test_set_resource(TEST_RESOURCE_LAYOUT, "{\"id\": \"root\", \"stack\": \"vertical\", \"spacing\": 4, \"layers\": ["
+        "{\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": [0, 0, 144, 30], \"frame@bw\": [0, 40, 144, 30],"
+            "\"anchor\": \"center\", \"text\": \"{title}\"},"
+        "{\"id\": \"details\", \"if\": \"bw\", \"lazy\": true, \"frame\": [0, 0, \"50%\", 20]}]}");
+    Layout *layout = test_layout_create();
+    host_set_log_level(0);
+    layout_parse_stream(layout, TEST_RESOURCE_LAYOUT);
+    TextLayer *title = layout_find_by_id(layout, "title");
+    if (check(title != NULL)) check_str(text_layer_get_text(title), "{title}");
+    check_rect(test_frame(layout, "title"), 0, 0, 144, 30);
+    layout_set_value(layout, "title", "Hello");
+    host_run_timers();
+    if (title) check_str(text_layer_get_text(title), "{title}");
+    check(layout_find_by_id(layout, "details") != NULL);
+    check_rect(test_frame(layout, "details"), 0, 0, 0, 0);
+    layout_destroy(layout);
+}
+
+const struct Test test_stream[] = {
+    { "same as parse", prv_same_as_parse },
+    { "larger than window", prv_larger_than_window },
+    { "escapes", prv_escapes },
+    { "escape on window boundary", prv_escape_on_window_boundary },
+    { "long keys", prv_long_keys },
+    { "unsupported members", prv_unsupported_members },
+    { NULL }
+};
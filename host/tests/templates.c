@@ -0,0 +1,156 @@
+#include "test.h"
+
+static const char *s_row = "{\"frame\": [0, 0, 144, 40], \"background\": \"#FF0000\", \"layers\": ["
+    "{\"id\": \"title\", \"type\": \"TextLayer\", \"text\": \"Default\", \"font\": \"GOTHIC_24\", \"frame\": [2, 2, 100, 30]},"
+    "{\"id\": \"icon\", \"type\": \"BitmapLayer\", \"bitmap\": \"ICON\", \"frame\": [110, 4, 30, 30]}]}";
+
+static void prv_instances(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    LayoutTemplate *row = layout_template_create(layout, strdup(s_row));
+    check(row != NULL);
+    Layer *root = layout_get_root_layer(layout);
+    Layer *first = layout_template_instantiate(row, NULL, 0);
+    Layer *second = layout_template_instantiate(row, NULL, 0);
+    check(first != NULL && second != NULL && first != second);
+    if (first && second) {
+        layer_add_child(root, first);
+        layer_add_child(root, second);
+        check_rect(layer_get_frame(first), 0, 0, 144, 40);
+    }
+    // Without overrides, both instances register the same id and the first one wins.
+    TextLayer *title = layout_find_by_id(layout, "title");
+    check(title != NULL);
+    if (title) {
+        check_str(text_layer_get_text(title), "Default");
+        check(layer_get_parent(text_layer_get_layer(title)) == first);
+    }
+    layout_destroy(layout);
+}
+
+static void prv_overrides(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    LayoutTemplate *row = layout_template_create(layout, strdup(s_row));
+    char ids[3][16];
+    for (int i = 0; i < 3; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "title%d", i);
+        LayoutOverride overrides[] = {
+            { "title", "id", ids[i] },
+            { "title", "text", i == 1 ? "Second" : "Row" },
+            { "title", "color", "#00FF00" },
+            { "title", "frame", "1, 2, 3, 4" },
+            { "title", "alignment", "GTextAlignmentRight" }
+        };
+        layer_add_child(layout_get_root_layer(layout), layout_template_instantiate(row, overrides, ARRAY_LENGTH(overrides)));
+    }
+    TextLayer *second = layout_find_by_id(layout, "title1");
+    check(second != NULL);
+    if (second) {
+        check_str(text_layer_get_text(second), "Second");
+        check_int(host_text_layer_get_text_color(second).argb, GColorFromHEX(0x00FF00).argb);
+        check_int(host_text_layer_get_alignment(second), GTextAlignmentRight);
+        check_rect(layer_get_frame(text_layer_get_layer(second)), 1, 2, 3, 4);
+    }
+    TextLayer *third = layout_find_by_id(layout, "title2");
+    if (check(third != NULL)) check_str(text_layer_get_text(third), "Row");
+    check(layout_find_by_id(layout, "title") == NULL);
+    layout_destroy(layout);
+}
+
+static void prv_from_resource(void) {
+    test_set_resource(TEST_RESOURCE_LAYOUT, s_row);
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    LayoutTemplate *row = layout_template_create_with_resource(layout, TEST_RESOURCE_LAYOUT);
+    Layer *layer = layout_template_instantiate(row, NULL, 0);
+    check(layer != NULL);
+    if (layer) layer_add_child(layout_get_root_layer(layout), layer);
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    check(icon != NULL && bitmap_layer_get_bitmap(icon) != NULL);
+    layout_destroy(layout);
+}
+
+// Instances are positioned once, so relative frames are left out rather than misread.
+static void prv_relative_frames(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    host_set_log_level(0);
+    LayoutTemplate *row = layout_template_create(layout, strdup("{\"frame\": [0, 0, \"50%\", 40], \"anchor\": \"center\"}"));
+    Layer *layer = layout_template_instantiate(row, NULL, 0);
+    if (check(layer != NULL)) {
+        check_rect(layer_get_frame(layer), 0, 0, 0, 0);
+        layer_add_child(layout_get_root_layer(layout), layer);
+    }
+    layout_destroy(layout);
+}
+
+// Destroying instances gives back their layers, records and ids, so rows can come and go.
+static void prv_destroy_instance(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    LayoutTemplate *row = layout_template_create(layout, strdup(s_row));
+    LayoutStats before;
+    for (int i = 0; i < 20; i++) {
+        char id[16];
+        snprintf(id, sizeof(id), "title%d", i);
+        LayoutOverride overrides[] = { { "title", "id", id } };
+        Layer *layer = layout_template_instantiate(row, overrides, ARRAY_LENGTH(overrides));
+        layer_add_child(layout_get_root_layer(layout), layer);
+        check(layout_find_by_id(layout, id) != NULL);
+        layout_template_destroy_instance(row, layer);
+        check(layout_find_by_id(layout, id) == NULL);
+        if (i == 0) layout_get_stats(layout, &before);
+    }
+    LayoutStats after;
+    layout_get_stats(layout, &after);
+    check_int(after.num_layers, 1);
+    check_int(after.arena_bytes, before.arena_bytes);
+    check_int(after.buffer_bytes, before.buffer_bytes);
+    layout_destroy(layout);
+}
+
+// Placeholders are not bound in templates; the text is set as written.
+static void prv_no_bindings(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    host_set_log_level(0);
+    LayoutTemplate *row = layout_template_create(layout, strdup("{\"id\": \"t\", \"type\": \"TextLayer\", \"text\": \"{name}\"}"));
+    layer_add_child(layout_get_root_layer(layout), layout_template_instantiate(row, NULL, 0));
+    layout_set_value(layout, "name", "value");
+    host_run_timers();
+    TextLayer *text = layout_find_by_id(layout, "t");
+    if (check(text != NULL)) check_str(text_layer_get_text(text), "{name}");
+    layout_destroy(layout);
+}
+
+// The cache belongs to the app, so instances share one copy and it empties when the layers go.
+static void prv_shared_bitmaps(void) {
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    LayoutTemplate *row = layout_template_create(layout, strdup(s_row));
+    uint16_t num_bitmaps;
+    for (int i = 0; i < 3; i++) layout_template_instantiate(row, NULL, 0);
+    check(layout_bitmap_get_stats(&num_bitmaps) > 0);
+    check_int(num_bitmaps, 1);
+    layout_destroy(layout);
+    check_int(layout_bitmap_get_stats(&num_bitmaps), 0);
+    check_int(num_bitmaps, 0);
+}
+
+// A bitmap the app sets itself is not in the cache, and the layer still frees it.
+static void prv_own_bitmaps(void) {
+    size_t before = heap_bytes_used();
+    Layout *layout = test_layout_parse("{\"id\": \"root\"}");
+    LayoutTemplate *row = layout_template_create(layout, strdup("{\"id\": \"icon\", \"type\": \"BitmapLayer\"}"));
+    layer_add_child(layout_get_root_layer(layout), layout_template_instantiate(row, NULL, 0));
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    if (check(icon != NULL)) bitmap_layer_set_bitmap(icon, gbitmap_create_with_resource(TEST_RESOURCE_ICON));
+    layout_destroy(layout);
+    check_int(heap_bytes_used(), before);
+}
+
+const struct Test test_templates[] = {
+    { "instances", prv_instances },
+    { "overrides", prv_overrides },
+    { "from resource", prv_from_resource },
+    { "relative frames", prv_relative_frames },
+    { "destroy instance", prv_destroy_instance },
+    { "no bindings", prv_no_bindings },
+    { "shared bitmaps", prv_shared_bitmaps },
+    { "own bitmaps", prv_own_bitmaps },
+    { NULL }
+};
@@ -0,0 +1,171 @@
+#include "test.h"
+
+static const char *s_layout = "{\"id\": \"root\", \"layers\": ["
+    "{\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": [0, 0, 144, 30], \"text\": \"Hello\"},"
+    "{\"id\": \"icon\", \"type\": \"BitmapLayer\", \"frame\": [0, 30, 20, 20], \"bitmap\": \"ICON\"},"
+    "{\"id\": \"box\", \"frame\": [0, 50, 144, 20]}]}";
+
+static void prv_reuses_layers(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    Layer *root = layout_get_root_layer(layout);
+    TextLayer *title = layout_find_by_id(layout, "title");
+    BitmapLayer *icon = layout_find_by_id(layout, "icon");
+    const GBitmap *bitmap = bitmap_layer_get_bitmap(icon);
+
+    layout_update_string(layout, strdup("{\"id\": \"root\", \"layers\": ["
+        "{\"id\": \"icon\", \"type\": \"BitmapLayer\", \"frame\": [0, 30, 20, 20], \"bitmap\": \"ICON\"},"
+        "{\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": [0, 0, 144, 40], \"text\": \"World\"}]}"));
+    check(layout_get_root_layer(layout) == root);
+    check(layout_find_by_id(layout, "title") == title);
+    check(layout_find_by_id(layout, "icon") == icon);
+    // An unchanged bitmap is not loaded again.
+    check(bitmap_layer_get_bitmap(icon) == bitmap);
+    check_str(text_layer_get_text(title), "World");
+    check_rect(test_frame(layout, "title"), 0, 0, 144, 40);
+    check(layer_get_parent(text_layer_get_layer(title)) == root);
+    layout_destroy(layout);
+}
+
+static void prv_removes_and_adds(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    layout_update_string(layout, strdup("{\"id\": \"root\", \"layers\": ["
+        "{\"id\": \"title\", \"type\": \"TextLayer\", \"text\": \"Hello\"},"
+        "{\"id\": \"added\", \"type\": \"TextLayer\", \"text\": \"New\"}]}"));
+    check(layout_find_by_id(layout, "icon") == NULL);
+    check(layout_find_by_id(layout, "box") == NULL);
+    check(layout_find_by_id(layout, "added") != NULL);
+    check(layer_get_parent(test_layer(layout, "added")) == layout_get_root_layer(layout));
+    layout_destroy(layout);
+}
+
+static void prv_type_change_recreates(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    void *box = layout_find_by_id(layout, "box");
+    layout_update_string(layout, strdup("{\"id\": \"root\", \"layers\": ["
+        "{\"id\": \"box\", \"type\": \"TextLayer\", \"text\": \"Now text\"}]}"));
+    TextLayer *text = layout_find_by_id(layout, "box");
+    check(text != NULL && text != box);
+    if (text) check_str(text_layer_get_text(text), "Now text");
+    layout_destroy(layout);
+}
+
+// Values the new document leaves out end up as a fresh parse of it would have them.
+static void prv_dropped_values(void) {
+    const char *updated = "{\"layers\": [{\"id\": \"title\", \"type\": \"TextLayer\", \"frame\": [0, 0, 144, 30]}]}";
+    Layout *fresh = test_layout_parse(updated);
+    TextLayer *expected = layout_find_by_id(fresh, "title");
+    Layout *layout = test_layout_parse("{\"layers\": [{\"id\": \"title\", \"type\": \"TextLayer\","
+        "\"frame\": [0, 0, 144, 30], \"text\": \"hi\", \"color\": \"#FFFFFF\"}]}");
+    layout_update_string(layout, strdup(updated));
+    TextLayer *title = layout_find_by_id(layout, "title");
+    if (check(title != NULL && expected != NULL)) {
+        check_str(text_layer_get_text(title), text_layer_get_text(expected));
+        check_int(host_text_layer_get_text_color(title).argb, host_text_layer_get_text_color(expected).argb);
+        check_rect(test_frame(layout, "title"), 0, 0, 144, 30);
+    }
+    // Once an update has seen the layer, the same holds for the next one.
+    layout_update_string(layout, strdup("{\"layers\": [{\"id\": \"title\", \"type\": \"TextLayer\", \"text\": \"hi\"}]}"));
+    layout_update_string(layout, strdup(updated));
+    title = layout_find_by_id(layout, "title");
+    if (check(title != NULL)) check_str(text_layer_get_text(title), text_layer_get_text(expected));
+    layout_destroy(layout);
+    layout_destroy(fresh);
+}
+
+static void prv_moves_between_parents(void) {
+    Layout *layout = test_layout_parse("{\"layers\": [{\"id\": \"a\", \"layers\": [{\"id\": \"child\"}]}, {\"id\": \"b\"}]}");
+    Layer *child = test_layer(layout, "child");
+    layout_update_string(layout, strdup("{\"layers\": [{\"id\": \"a\"}, {\"id\": \"b\", \"layers\": [{\"id\": \"child\"}]}]}"));
+    check(test_layer(layout, "child") == child);
+    check(layer_get_parent(child) == test_layer(layout, "b"));
+    layout_destroy(layout);
+}
+
+// Pushing the same document again and again takes no more memory after the first time.
+static void prv_repeated_updates(void) {
+    for (int zero_copy = 0; zero_copy < 2; zero_copy++) {
+        Layout *layout = test_layout_create();
+        layout_set_zero_copy(layout, zero_copy);
+        layout_parse_string(layout, strdup(s_layout));
+        layout_update_string(layout, strdup(s_layout));
+        LayoutStats before;
+        layout_get_stats(layout, &before);
+        for (int i = 0; i < 30; i++) layout_update_string(layout, strdup(s_layout));
+        LayoutStats after;
+        layout_get_stats(layout, &after);
+        check_int(after.arena_bytes, before.arena_bytes);
+        check_int(after.buffer_bytes, before.buffer_bytes);
+        check_int(after.num_layers, before.num_layers);
+        // Strings now point into the last document, so the earlier ones could go.
+        TextLayer *title = layout_find_by_id(layout, "title");
+        if (check(title != NULL)) check_str(text_layer_get_text(title), "Hello");
+        layout_destroy(layout);
+    }
+}
+
+// Text that changes every update, and layers recreated every update, take no more memory
+// after the first time either.
+static void prv_changing_updates(void) {
+    for (int zero_copy = 0; zero_copy < 2; zero_copy++) {
+        Layout *layout = test_layout_create();
+        layout_set_zero_copy(layout, zero_copy);
+        layout_parse_string(layout, strdup(s_layout));
+        LayoutStats before;
+        char json[256];
+        for (int i = 0; i < 200; i++) {
+            // Longer text every few updates, and "box" alternates between two types.
+            snprintf(json, sizeof(json), "{\"id\": \"root\", \"layers\": ["
+                "{\"id\": \"title\", \"type\": \"TextLayer\", \"text\": \"Update %d%*s\"},"
+                "{\"id\": \"box\", \"type\": \"%s\", \"text\": \"%d\"}]}",
+                i, i % 7, "", i % 2 ? "TextLayer" : "Layer", i);
+            layout_update_string(layout, strdup(json));
+            if (i == 9) layout_get_stats(layout, &before);
+        }
+        LayoutStats after;
+        layout_get_stats(layout, &after);
+        check_int(after.arena_bytes, before.arena_bytes);
+        check_int(after.num_layers, before.num_layers);
+        TextLayer *title = layout_find_by_id(layout, "title");
+        if (check(title != NULL)) check_str(text_layer_get_text(title), "Update 199   ");
+        layout_destroy(layout);
+    }
+}
+
+// Records of destroyed layers are used again by later updates.
+static void prv_recycles_records(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    LayoutHandle box = layout_get_handle(layout, "box");
+    layout_update_string(layout, strdup("{\"id\": \"root\"}"));
+    layout_update_string(layout, strdup("{\"id\": \"root\", \"layers\": [{\"id\": \"other\"}]}"));
+    // A new record would have the next position after the last one.
+    LayoutHandle other = layout_get_handle(layout, "other");
+    check((other & 0xFFFF) <= (box & 0xFFFF));
+    // The handle of the destroyed layer does not find the one that took its record.
+    check(other != box);
+    check(layout_get_layer(layout, box) == NULL);
+    check(layout_get_layer(layout, other) == test_layer(layout, "other"));
+    layout_destroy(layout);
+}
+
+static void prv_invalid_keeps_layout(void) {
+    Layout *layout = test_layout_parse(s_layout);
+    void *title = layout_find_by_id(layout, "title");
+    host_set_log_level(0);
+    layout_update_string(layout, strdup("[1, 2, 3]"));
+    check(layout_find_by_id(layout, "title") == title);
+    check(layout_find_by_id(layout, "icon") != NULL);
+    layout_destroy(layout);
+}
+
+const struct Test test_update[] = {
+    { "reuses layers", prv_reuses_layers },
+    { "removes and adds", prv_removes_and_adds },
+    { "type change recreates", prv_type_change_recreates },
+    { "dropped values", prv_dropped_values },
+    { "moves between parents", prv_moves_between_parents },
+    { "repeated updates", prv_repeated_updates },
+    { "changing updates", prv_changing_updates },
+    { "recycles records", prv_recycles_records },
+    { "invalid keeps layout", prv_invalid_keeps_layout },
+    { NULL }
+};
@@ -11,25 +11,59 @@ typedef enum {
     JSON_PRIMITIVE = 4
 } JsonType;
 
+// Resources can never exceed 64 KB, so token offsets fit in 16 bits. Build with
+// -DJSON_WIDE_TOKENS to use int-sized tokens when parsing larger strings.
+//
+// Every token records next, the index of the first token after its subtree.
+#if !defined(JSON_WIDE_TOKENS) && !defined(JSON_PACKED_TOKENS)
+#define JSON_PACKED_TOKENS
+#endif
+
+#ifdef JSON_PACKED_TOKENS
+typedef struct {
+    uint16_t start;
+    uint16_t len;
+    uint16_t size : 13;
+    uint16_t type : 3;
+    uint16_t next;
+} JsonToken;
+#else
 typedef struct {
     JsonType type;
     int start;
     int end;
     int len;
     int size;
+    int next;
 } JsonToken;
+#endif
 
+char *json_load_resource(uint32_t resource_id);
 Json *json_create_with_resource(uint32_t resource_id);
 Json *json_create(char *s);
 void json_destroy(Json *this);
+char *json_detach_buffer(Json *this);
+size_t json_get_text_size(Json *this);
+size_t json_get_heap_size(Json *this);
 bool json_has_next(Json *this);
 JsonToken *json_next(Json *this);
 char *json_next_string(Json *this);
+const char *json_next_string_view(Json *this);
 int json_next_int(Json *this);
+int32_t json_next_fixed(Json *this, uint8_t fraction_bits);
 bool json_next_bool(Json *this);
 GRect json_next_grect(Json *this);
 GColor json_next_gcolor(Json *this);
 void json_skip_tree(Json *this);
+Json *json_copy_tree(Json *this);
+int16_t json_get_num_tokens(Json *this);
+int16_t json_get_num_objects(Json *this);
 int16_t json_get_index(Json *this);
 void json_set_index(Json *this, int16_t index);
 bool json_eq(Json *this, JsonToken *tok, const char *s);
+const char *json_token_text(Json *this, JsonToken *tok);
+int json_parse_int(const char *s, size_t len);
+int32_t json_parse_fixed(const char *s, size_t len, uint8_t fraction_bits);
+bool json_parse_bool(const char *s, size_t len);
+GColor json_parse_gcolor(const char *s, size_t len);
+GRect json_parse_grect(const char *s, size_t len);
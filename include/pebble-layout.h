@@ -3,19 +3,99 @@
 #include "json.h"
 
 typedef struct Layout Layout;
+typedef struct LayoutTemplate LayoutTemplate;
 
 typedef void* (*LayoutCreateFunc)(Layout *layout, Json *json, JsonToken *token);
 typedef void (*LayoutDestroyFunc)(void *object);
 typedef Layer* (*LayoutGetLayerFunc)(void *object);
 typedef void (*LayoutSetFrameFunc)(void *object, GRect frame);
+typedef void (*LayoutUpdateFunc)(Layout *layout, void *object, Json *json, JsonToken *token);
+
+typedef enum {
+    LayoutPropertyBool,
+    LayoutPropertyInt,
+    LayoutPropertyColor,
+    LayoutPropertyString,
+    LayoutPropertyEnum,
+    LayoutPropertyFont,
+    LayoutPropertyResource,
+    LayoutPropertyRect,
+    LayoutPropertyLayers
+} LayoutPropertyKind;
+
+typedef union {
+    bool boolean;
+    int integer;
+    GColor color;
+    char *string;
+    GFont font;
+    uint32_t resource_id;
+    GRect rect;
+    Layer *layer;
+} LayoutValue;
+
+typedef void (*LayoutPropertySetter)(Layout *layout, void *object, LayoutValue value);
+
+typedef struct {
+    const char *name;
+    int value;
+} LayoutEnumValue;
+
+typedef struct {
+    const char *name;
+    LayoutPropertyKind kind;
+    LayoutPropertySetter set;
+    const LayoutEnumValue *values;
+} LayoutProperty;
 
 typedef struct {
     LayoutCreateFunc create;
     LayoutDestroyFunc destroy;
     LayoutGetLayerFunc get_layer;
     LayoutSetFrameFunc set_frame;
+    const LayoutProperty *properties;
+    LayoutUpdateFunc update;
 } LayoutFuncs;
 
+typedef struct {
+    const char *id;
+    const char *property;
+    const char *value;
+} LayoutOverride;
+
+typedef struct {
+    size_t parse_json_bytes;
+    size_t parse_peak_bytes;
+    size_t arena_bytes;
+    size_t dict_bytes;
+    size_t buffer_bytes;
+    size_t layer_bytes;
+    uint16_t num_layers;
+    size_t font_bytes;
+    uint16_t num_fonts;
+} LayoutStats;
+
+typedef void (*LayoutTypeStatsCallback)(const char *type, uint16_t num_layers, size_t bytes, void *context);
+
+// Milliseconds spent in each phase of the last layout_parse() or layout_parse_string().
+typedef struct {
+    uint32_t load_ms;
+    uint32_t tokenize_ms;
+    uint32_t create_ms;
+    uint32_t root_ms;
+    uint16_t num_tokens;
+} LayoutProfile;
+
+typedef void (*LayoutTypeProfileCallback)(const char *type, uint16_t num_created, uint32_t create_ms, void *context);
+
+// A layer's record in the low 16 bits, and how often that record had been used again when the
+// layer was created in the high 16 bits. It stays valid until the layer is destroyed.
+typedef uint32_t LayoutHandle;
+
+#define LAYOUT_HANDLE_NONE UINT32_MAX
+
+typedef bool (*LayoutForeachCallback)(LayoutHandle handle, void *object, Layer *layer, void *context);
+
 typedef enum {
     StandardTypeText = 1,
     StandardTypeBitmap,
@@ -27,12 +107,39 @@ void layout_add_all_standard_types(Layout *this);
 void layout_add_standard_type(Layout *this, StandardType type);
 void layout_parse(Layout *this, uint32_t resource_id);
 void layout_parse_string(Layout *this, char *json);
+void layout_parse_binary(Layout *this, uint32_t resource_id);
+void layout_parse_stream(Layout *this, uint32_t resource_id);
+void layout_update_string(Layout *this, char *json);
 void layout_destroy(Layout *this);
+void layout_set_value(Layout *this, const char *name, const char *value);
+void layout_set_value_int(Layout *this, const char *name, int value);
+void layout_set_zero_copy(Layout *this, bool zero_copy);
+void layout_get_stats(Layout *this, LayoutStats *stats);
+void layout_foreach_type_stats(Layout *this, LayoutTypeStatsCallback callback, void *context);
+bool layout_get_profile(Layout *this, LayoutProfile *profile);
+void layout_foreach_type_profile(Layout *this, LayoutTypeProfileCallback callback, void *context);
+void layout_log_profile(Layout *this);
+void layout_dump_trace(void);
 Layer *layout_get_root_layer(Layout *this);
 void *layout_find_by_id(Layout *this, char *id);
+LayoutHandle layout_get_handle(Layout *this, char *id);
+void *layout_get_object(Layout *this, LayoutHandle handle);
+Layer *layout_get_layer(Layout *this, LayoutHandle handle);
+void layout_foreach(Layout *this, LayoutForeachCallback callback, void *context);
+void layout_show(Layout *this, char *id);
+void layout_hide(Layout *this, char *id, bool destroy);
+void layout_set_frame(Layout *this, char *id, const char *frame);
 void layout_add_type(Layout *this, char *type, LayoutFuncs layout_funcs);
 void layout_add_system_fonts(Layout *this);
 void layout_add_font(Layout *this, char *name, uint32_t resource_id);
 GFont layout_get_font(Layout* this, char *name);
 void layout_add_resource(Layout *this, char *name, uint32_t resource_id);
 uint32_t *layout_get_resource(Layout *this, char *name);
+GBitmap *layout_bitmap_acquire(uint32_t resource_id);
+bool layout_bitmap_release(GBitmap *bitmap);
+void layout_bitmap_keep_alive(uint32_t resource_id, bool keep_alive);
+size_t layout_bitmap_get_stats(uint16_t *num_bitmaps);
+LayoutTemplate *layout_template_create(Layout *layout, char *json);
+LayoutTemplate *layout_template_create_with_resource(Layout *layout, uint32_t resource_id);
+Layer *layout_template_instantiate(LayoutTemplate *this, const LayoutOverride *overrides, uint8_t num_overrides);
+void layout_template_destroy_instance(LayoutTemplate *this, Layer *layer);
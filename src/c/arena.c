@@ -0,0 +1,96 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+
+// Every allocation is rounded up so pointers and ints handed out stay aligned.
+#define ARENA_ALIGN (sizeof(void *) > 4 ? sizeof(void *) : 4)
+#define ARENA_ROUND(n) (((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+
+struct Chunk {
+    struct Chunk *next;
+    size_t size;
+    size_t used;
+};
+
+#define CHUNK_HEADER ARENA_ROUND(sizeof(struct Chunk))
+
+struct Arena {
+    struct Chunk *chunks;
+    size_t chunk_size;
+};
+
+// Allocations come from the first chunk. A chunk that is not made current is filled by the
+// caller straight away, so the current one keeps its free space.
+static struct Chunk *prv_add_chunk(Arena *this, size_t size, bool current) {
+    logf();
+    struct Chunk *chunk = malloc(CHUNK_HEADER + size);
+    if (!chunk) return NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    if (!current && this->chunks) {
+        chunk->next = this->chunks->next;
+        this->chunks->next = chunk;
+    } else {
+        chunk->next = this->chunks;
+        this->chunks = chunk;
+    }
+    return chunk;
+}
+
+Arena *arena_create(size_t chunk_size) {
+    logf();
+    Arena *this = malloc(sizeof(Arena));
+    this->chunks = NULL;
+    this->chunk_size = ARENA_ROUND(chunk_size);
+    return this;
+}
+
+void arena_destroy(Arena *this) {
+    logf();
+    struct Chunk *chunk = this->chunks;
+    while (chunk) {
+        struct Chunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    this->chunks = NULL;
+    free(this);
+}
+
+size_t arena_get_size(Arena *this) {
+    logf();
+    size_t size = sizeof(Arena);
+    for (struct Chunk *chunk = this->chunks; chunk; chunk = chunk->next) size += CHUNK_HEADER + chunk->size;
+    return size;
+}
+
+void arena_reserve(Arena *this, size_t size) {
+    logf();
+    size = ARENA_ROUND(size);
+    struct Chunk *chunk = this->chunks;
+    if (chunk && chunk->size - chunk->used >= size) return;
+    prv_add_chunk(this, size > this->chunk_size ? size : this->chunk_size, true);
+}
+
+void *arena_alloc(Arena *this, size_t size) {
+    logf();
+    size = ARENA_ROUND(size);
+    struct Chunk *chunk = this->chunks;
+    if (!chunk || chunk->size - chunk->used < size) {
+        chunk = prv_add_chunk(this, size > this->chunk_size ? size : this->chunk_size, size <= this->chunk_size);
+        if (!chunk) return NULL;
+    }
+    void *p = (uint8_t *) chunk + CHUNK_HEADER + chunk->used;
+    chunk->used += size;
+    return p;
+}
+
+char *arena_strndup(Arena *this, const char *s, size_t len) {
+    logf();
+    char *copy = arena_alloc(this, len + 1);
+    if (!copy) return NULL;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    return copy;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <pebble.h>
+
+typedef struct Arena Arena;
+
+Arena *arena_create(size_t chunk_size);
+void arena_destroy(Arena *this);
+size_t arena_get_size(Arena *this);
+void *arena_alloc(Arena *this, size_t size);
+void arena_reserve(Arena *this, size_t size);
+char *arena_strndup(Arena *this, const char *s, size_t len);
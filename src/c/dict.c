@@ -1,109 +1,140 @@
 #include <pebble.h>
-#include <@smallstoneapps/linked-list/linked-list.h>
 #include "string.h"
 #include "logging.h"
 #include "dict.h"
 
-struct Dict {
-    LinkedRoot *entries;
-};
+#define DICT_MIN_CAPACITY 8
 
 struct Entry {
+    uint32_t hash;
     char *key;
     void *value;
 };
 
+struct Dict {
+    struct Entry *entries;
+    uint16_t capacity;
+    uint16_t count;
+};
+
+uint32_t dict_hash(const char *key, size_t len) {
+    logf();
+    // 32-bit FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t) key[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 Dict *dict_create(void) {
     logf();
     Dict *this = malloc(sizeof(Dict));
     this->entries = NULL;
+    this->capacity = 0;
+    this->count = 0;
     return this;
 }
 
-static bool prv_destroy_callback(void *object, void *context) {
+void dict_destroy(Dict *this) {
+    logf();
+    free(this->entries);
+    this->entries = NULL;
+    free(this);
+}
+
+size_t dict_get_size(Dict *this) {
     logf();
-    free(object);
-    object = NULL;
-    return true;
+    return sizeof(Dict) + (this->entries ? sizeof(struct Entry) * this->capacity : 0);
 }
 
-void dict_destroy(Dict *this) {
+static void prv_insert(struct Entry *entries, uint16_t capacity, uint32_t hash, char *key, void *value) {
     logf();
+    uint16_t mask = capacity - 1;
+    uint16_t i = hash & mask;
+    while (entries[i].key) i = (i + 1) & mask;
+    entries[i].hash = hash;
+    entries[i].key = key;
+    entries[i].value = value;
+}
+
+static void prv_grow(Dict *this) {
+    logf();
+    uint16_t capacity = this->capacity ? this->capacity * 2 : DICT_MIN_CAPACITY;
+    struct Entry *entries = calloc(capacity, sizeof(struct Entry));
     if (this->entries) {
-        linked_list_foreach(this->entries, prv_destroy_callback, NULL);
-        linked_list_clear(this->entries);
+        // Start just past an empty slot so every probe run is reinserted in its original
+        // order, which keeps the first of several equal keys winning lookups.
+        uint16_t start = 0;
+        while (this->entries[start].key) start++;
+        for (uint16_t n = 1; n <= this->capacity; n++) {
+            struct Entry *entry = &this->entries[(start + n) & (this->capacity - 1)];
+            if (entry->key) prv_insert(entries, capacity, entry->hash, entry->key, entry->value);
+        }
         free(this->entries);
-        this->entries = NULL;
     }
-    free(this);
+    this->entries = entries;
+    this->capacity = capacity;
 }
 
 void dict_put(Dict *this, char *key, void *value) {
     logf();
-    if (!this->entries) this->entries = linked_list_create_root();
-    struct Entry *entry = malloc(sizeof(struct Entry));
-    entry->key = key;
-    entry->value = value;
-    linked_list_append(this->entries, entry);
+    if ((this->count + 1) * 4 > this->capacity * 3) prv_grow(this);
+    prv_insert(this->entries, this->capacity, dict_hash(key, strlen(key)), key, value);
+    this->count++;
 }
 
-static bool prv_find_by_key_callback(void *object1, void *object2) {
+static struct Entry *prv_find(Dict *this, const char *key, size_t len) {
     logf();
-    char *key = (char *) object1;
-    struct Entry *entry = (struct Entry *) object2;
-    return strcmp(key, entry->key) == 0;
+    if (!this->entries) return NULL;
+    uint32_t hash = dict_hash(key, len);
+    uint16_t mask = this->capacity - 1;
+    for (uint16_t i = hash & mask; this->entries[i].key; i = (i + 1) & mask) {
+        struct Entry *entry = &this->entries[i];
+        if (entry->hash == hash && strncmp(entry->key, key, len) == 0 && entry->key[len] == '\0') return entry;
+    }
+    return NULL;
 }
 
 bool dict_contains(Dict *this, char *key) {
     logf();
-    if (!this->entries) return false;
-    return linked_list_find_compare(this->entries, key, prv_find_by_key_callback) >= 0;
+    return prv_find(this, key, strlen(key)) != NULL;
 }
 
 void *dict_get(Dict *this, char *key) {
     logf();
-    if (!this->entries) return NULL;
-    int16_t index = linked_list_find_compare(this->entries, key, prv_find_by_key_callback);
-    if (index < 0) return NULL;
-    struct Entry *entry = (struct Entry *) linked_list_get(this->entries, index);
-    return entry->value;
+    struct Entry *entry = prv_find(this, key, strlen(key));
+    return entry ? entry->value : NULL;
 }
 
 void *dict_remove(Dict *this, char *key) {
     logf();
-    if (!this->entries) return NULL;
-    int16_t index = linked_list_find_compare(this->entries, key, prv_find_by_key_callback);
-    if (index < 0) return NULL;
-    struct Entry *entry = (struct Entry *) linked_list_get(this->entries, index);
+    struct Entry *entry = prv_find(this, key, strlen(key));
+    if (!entry) return NULL;
     void *value = entry->value;
-    free(entry);
 
-    if (linked_list_count(this->entries) == 0) {
-        free(this->entries);
-        this->entries = NULL;
+    // Backward-shift deletion: pull later members of the probe run into the hole so
+    // lookups never need tombstones.
+    uint16_t mask = this->capacity - 1;
+    uint16_t hole = entry - this->entries;
+    for (uint16_t i = (hole + 1) & mask; this->entries[i].key; i = (i + 1) & mask) {
+        uint16_t home = this->entries[i].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            this->entries[hole] = this->entries[i];
+            hole = i;
+        }
     }
+    this->entries[hole].key = NULL;
+    this->count--;
 
     return value;
 }
 
-struct ForEachData {
-    DictForEachCallback callback;
-    void *context;
-};
-
-static bool prv_foreach_callback(void *object, void *context) {
-    logf();
-    struct Entry *entry = (struct Entry *) object;
-    struct ForEachData *data = (struct ForEachData *) context;
-    return data->callback(entry->key, entry->value, data->context);
-}
-
 void dict_foreach(Dict *this, DictForEachCallback callback, void *context) {
     logf();
-    if (!this->entries) return;
-    struct ForEachData data = {
-        .callback = callback,
-        .context = context
-    };
-    linked_list_foreach(this->entries, prv_foreach_callback, &data);
+    for (uint16_t i = 0; i < this->capacity; i++) {
+        struct Entry *entry = &this->entries[i];
+        if (entry->key && !callback(entry->key, entry->value, context)) break;
+    }
 }
@@ -4,9 +4,13 @@ typedef struct Dict Dict;
 
 typedef bool (*DictForEachCallback)(char *key, void *value, void *context);
 
+uint32_t dict_hash(const char *key, size_t len);
 Dict *dict_create(void);
 void dict_destroy(Dict *this);
+size_t dict_get_size(Dict *this);
 void dict_put(Dict *this, char *key, void *value);
 bool dict_contains(Dict *this, char *key);
 void *dict_get(Dict *this, char *key);
+// Removes the entry for key and returns its value, or NULL if there was none.
+void *dict_remove(Dict *this, char *key);
 void dict_foreach(Dict *this, DictForEachCallback callback, void *context);
@@ -6,18 +6,27 @@
 static jsmntok_t *jsmn_alloc_token(jsmn_parser *parser,
 		jsmntok_t *tokens, size_t num_tokens) {
 	jsmntok_t *tok;
-	if (parser->toknext >= num_tokens) {
+	if (parser->toknext >= num_tokens || parser->toknext >= JSMN_MAX_TOKENS) {
 		return NULL;
 	}
 	tok = &tokens[parser->toknext++];
-	tok->start = tok->end = -1;
+	tok->start = 0;
+	tok->len = 0;
 	tok->size = 0;
-#ifdef JSMN_PARENT_LINKS
-	tok->parent = -1;
-#endif
+	tok->next = parser->toknext;
 	return tok;
 }
 
+/**
+ * Sets the end boundary of a token.
+ */
+static void jsmn_close_token(jsmntok_t *token, int end) {
+	token->len = end - token->start;
+#ifndef JSON_PACKED_TOKENS
+	token->end = end;
+#endif
+}
+
 /**
  * Fills token type and boundaries.
  */
@@ -25,8 +34,8 @@ static void jsmn_fill_token(jsmntok_t *token, jsmntype_t type,
                             int start, int end) {
 	token->type = type;
 	token->start = start;
-	token->end = end;
 	token->size = 0;
+	jsmn_close_token(token, end);
 }
 
 /**
@@ -61,19 +70,12 @@ static int jsmn_parse_primitive(jsmn_parser *parser, const char *js,
 #endif
 
 found:
-	if (tokens == NULL) {
-		parser->pos--;
-		return 0;
-	}
 	token = jsmn_alloc_token(parser, tokens, num_tokens);
 	if (token == NULL) {
 		parser->pos = start;
 		return JSMN_ERROR_NOMEM;
 	}
 	jsmn_fill_token(token, JSMN_PRIMITIVE, start, parser->pos);
-#ifdef JSMN_PARENT_LINKS
-	token->parent = parser->toksuper;
-#endif
 	parser->pos--;
 	return 0;
 }
@@ -95,18 +97,12 @@ static int jsmn_parse_string(jsmn_parser *parser, const char *js,
 
 		/* Quote: end of string */
 		if (c == '\"') {
-			if (tokens == NULL) {
-				return 0;
-			}
 			token = jsmn_alloc_token(parser, tokens, num_tokens);
 			if (token == NULL) {
 				parser->pos = start;
 				return JSMN_ERROR_NOMEM;
 			}
 			jsmn_fill_token(token, JSMN_STRING, start+1, parser->pos);
-#ifdef JSMN_PARENT_LINKS
-			token->parent = parser->toksuper;
-#endif
 			return 0;
 		}
 
@@ -145,15 +141,48 @@ static int jsmn_parse_string(jsmn_parser *parser, const char *js,
 	return JSMN_ERROR_PART;
 }
 
+/**
+ * Returns the innermost open object or array, or -1 at the top level. Past
+ * JSMN_MAX_DEPTH it is found by scanning back for a container that has not
+ * been closed yet, which is one whose length is still zero.
+ */
+static int jsmn_innermost(jsmn_parser *parser, jsmntok_t *tokens) {
+	int i;
+	if (parser->depth == 0) {
+		return -1;
+	}
+	if (parser->depth <= JSMN_MAX_DEPTH) {
+		return parser->open[parser->depth - 1];
+	}
+	for (i = parser->toknext - 1; i >= 0; i--) {
+		if ((tokens[i].type == JSMN_OBJECT || tokens[i].type == JSMN_ARRAY) && tokens[i].len == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+/**
+ * Counts one more child of the open object, array or key, if there is one.
+ */
+static int jsmn_add_child(jsmn_parser *parser, jsmntok_t *tokens) {
+	if (parser->toksuper == -1) {
+		return 0;
+	}
+	if (tokens[parser->toksuper].size >= JSMN_MAX_SIZE) {
+		return JSMN_ERROR_NOMEM;
+	}
+	tokens[parser->toksuper].size++;
+	return 0;
+}
+
 /**
  * Parse JSON string and fill tokens.
  */
 int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 		jsmntok_t *tokens, unsigned int num_tokens) {
 	int r;
-	int i;
 	jsmntok_t *token;
-	int count = parser->toknext;
 
 	for (; parser->pos < len && js[parser->pos] != '\0'; parser->pos++) {
 		char c;
@@ -162,78 +191,38 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 		c = js[parser->pos];
 		switch (c) {
 			case '{': case '[':
-				count++;
-				if (tokens == NULL) {
-					break;
-				}
 				token = jsmn_alloc_token(parser, tokens, num_tokens);
 				if (token == NULL)
 					return JSMN_ERROR_NOMEM;
-				if (parser->toksuper != -1) {
-					tokens[parser->toksuper].size++;
-#ifdef JSMN_PARENT_LINKS
-					token->parent = parser->toksuper;
-#endif
-				}
+				r = jsmn_add_child(parser, tokens);
+				if (r < 0) return r;
 				token->type = (c == '{' ? JSMN_OBJECT : JSMN_ARRAY);
 				token->start = parser->pos;
 				parser->toksuper = parser->toknext - 1;
+				if (parser->depth < JSMN_MAX_DEPTH)
+					parser->open[parser->depth] = parser->toksuper;
+				parser->depth++;
 				break;
 			case '}': case ']':
-				if (tokens == NULL)
-					break;
 				type = (c == '}' ? JSMN_OBJECT : JSMN_ARRAY);
-#ifdef JSMN_PARENT_LINKS
-				if (parser->toknext < 1) {
-					return JSMN_ERROR_INVAL;
-				}
-				token = &tokens[parser->toknext - 1];
-				for (;;) {
-					if (token->start != -1 && token->end == -1) {
-						if (token->type != type) {
-							return JSMN_ERROR_INVAL;
-						}
-						token->end = parser->pos + 1;
-						parser->toksuper = token->parent;
-						break;
-					}
-					if (token->parent == -1) {
-						if(token->type != type || parser->toksuper == -1) {
-							return JSMN_ERROR_INVAL;
-						}
-						break;
-					}
-					token = &tokens[token->parent];
-				}
-#else
-				for (i = parser->toknext - 1; i >= 0; i--) {
-					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
-						if (token->type != type) {
-							return JSMN_ERROR_INVAL;
-						}
-						parser->toksuper = -1;
-						token->end = parser->pos + 1;
-						break;
-					}
-				}
 				/* Error if unmatched closing bracket */
-				if (i == -1) return JSMN_ERROR_INVAL;
-				for (; i >= 0; i--) {
-					token = &tokens[i];
-					if (token->start != -1 && token->end == -1) {
-						parser->toksuper = i;
-						break;
-					}
+				if (parser->depth == 0)
+					return JSMN_ERROR_INVAL;
+				token = &tokens[jsmn_innermost(parser, tokens)];
+				if (token->type != type) {
+					return JSMN_ERROR_INVAL;
 				}
-#endif
+				jsmn_close_token(token, parser->pos + 1);
+				/* Everything allocated since the opening bracket is inside it */
+				token->next = parser->toknext;
+				parser->depth--;
+				parser->toksuper = jsmn_innermost(parser, tokens);
 				break;
 			case '\"':
 				r = jsmn_parse_string(parser, js, len, tokens, num_tokens);
 				if (r < 0) return r;
-				count++;
-				if (parser->toksuper != -1 && tokens != NULL)
-					tokens[parser->toksuper].size++;
+				r = jsmn_add_child(parser, tokens);
+				if (r < 0) return r;
 				break;
 			case '\t' : case '\r' : case '\n' : case ' ':
 				break;
@@ -241,22 +230,7 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 				parser->toksuper = parser->toknext - 1;
 				break;
 			case ',':
-				if (tokens != NULL && parser->toksuper != -1 &&
-						tokens[parser->toksuper].type != JSMN_ARRAY &&
-						tokens[parser->toksuper].type != JSMN_OBJECT) {
-#ifdef JSMN_PARENT_LINKS
-					parser->toksuper = tokens[parser->toksuper].parent;
-#else
-					for (i = parser->toknext - 1; i >= 0; i--) {
-						if (tokens[i].type == JSMN_ARRAY || tokens[i].type == JSMN_OBJECT) {
-							if (tokens[i].start != -1 && tokens[i].end == -1) {
-								parser->toksuper = i;
-								break;
-							}
-						}
-					}
-#endif
-				}
+				parser->toksuper = jsmn_innermost(parser, tokens);
 				break;
 #ifdef JSMN_STRICT
 			/* In strict mode primitives are: numbers and booleans */
@@ -264,7 +238,7 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 			case '5': case '6': case '7' : case '8': case '9':
 			case 't': case 'f': case 'n' :
 				/* And they must not be keys of the object */
-				if (tokens != NULL && parser->toksuper != -1) {
+				if (parser->toksuper != -1) {
 					jsmntok_t *t = &tokens[parser->toksuper];
 					if (t->type == JSMN_OBJECT ||
 							(t->type == JSMN_STRING && t->size != 0)) {
@@ -277,9 +251,8 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 #endif
 				r = jsmn_parse_primitive(parser, js, len, tokens, num_tokens);
 				if (r < 0) return r;
-				count++;
-				if (parser->toksuper != -1 && tokens != NULL)
-					tokens[parser->toksuper].size++;
+				r = jsmn_add_child(parser, tokens);
+				if (r < 0) return r;
 				break;
 
 #ifdef JSMN_STRICT
@@ -290,16 +263,12 @@ int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 		}
 	}
 
-	if (tokens != NULL) {
-		for (i = parser->toknext - 1; i >= 0; i--) {
-			/* Unmatched opened object or array */
-			if (tokens[i].start != -1 && tokens[i].end == -1) {
-				return JSMN_ERROR_PART;
-			}
-		}
+	/* Unmatched opened object or array */
+	if (parser->depth > 0) {
+		return JSMN_ERROR_PART;
 	}
 
-	return count;
+	return parser->toknext;
 }
 
 /**
@@ -310,5 +279,6 @@ void jsmn_init(jsmn_parser *parser) {
 	parser->pos = 0;
 	parser->toknext = 0;
 	parser->toksuper = -1;
+	parser->depth = 0;
 }
 
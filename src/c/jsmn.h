@@ -2,27 +2,39 @@
 #define __JSMN_H_
 
 #include <stddef.h>
+#include "json.h"
 
-#define JSMN_PARENT_LINKS
+/* Open objects and arrays remembered by the parser. Deeper nesting still
+ * parses, but each bracket past this depth scans back for its parent. */
+#define JSMN_MAX_DEPTH 32
+
+/* Json indexes tokens with int16_t, and packed tokens count children in
+ * 13 bits. Larger documents fail with JSMN_ERROR_NOMEM instead of wrapping. */
+#define JSMN_MAX_TOKENS INT16_MAX
+#ifdef JSON_PACKED_TOKENS
+#define JSMN_MAX_SIZE ((1 << 13) - 1)
+#else
+#define JSMN_MAX_SIZE INT16_MAX
+#endif
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /**
- * JSON type identifier. Basic types are:
+ * JSON type identifier, the same as json.h's so tokens need no conversion.
+ * Basic types are:
  * 	o Object
  * 	o Array
  * 	o String
  * 	o Other primitive: number, boolean (true/false) or null
  */
-typedef enum {
-	JSMN_UNDEFINED = 0,
-	JSMN_OBJECT = 1,
-	JSMN_ARRAY = 2,
-	JSMN_STRING = 3,
-	JSMN_PRIMITIVE = 4
-} jsmntype_t;
+typedef JsonType jsmntype_t;
+#define JSMN_UNDEFINED JSON_UNDEFINED
+#define JSMN_OBJECT JSON_OBJECT
+#define JSMN_ARRAY JSON_ARRAY
+#define JSMN_STRING JSON_STRING
+#define JSMN_PRIMITIVE JSON_PRIMITIVE
 
 enum jsmnerr {
 	/* Not enough tokens were provided */
@@ -34,29 +46,22 @@ enum jsmnerr {
 };
 
 /**
- * JSON token description.
- * type		type (object, array, string etc.)
- * start	start position in JSON data string
- * end		end position in JSON data string
+ * JSON token description. Tokens are written straight into the JsonToken
+ * table used by json.c, so there is no intermediate token array to copy.
  */
-typedef struct {
-	jsmntype_t type;
-	int start;
-	int end;
-	int size;
-#ifdef JSMN_PARENT_LINKS
-	int parent;
-#endif
-} jsmntok_t;
+typedef JsonToken jsmntok_t;
 
 /**
  * JSON parser. Contains an array of token blocks available. Also stores
- * the string being parsed now and current position in that string
+ * the string being parsed now and current position in that string, and the
+ * chain of currently open objects and arrays.
  */
 typedef struct {
 	unsigned int pos; /* offset in the JSON string */
 	unsigned int toknext; /* next token to allocate */
 	int toksuper; /* superior token node, e.g parent object or array */
+	unsigned int depth; /* number of open objects and arrays */
+	int open[JSMN_MAX_DEPTH]; /* the outermost open objects and arrays */
 } jsmn_parser;
 
 /**
@@ -66,7 +71,7 @@ void jsmn_init(jsmn_parser *parser);
 
 /**
  * Run JSON parser. It parses a JSON data string into and array of tokens, each describing
- * a single JSON object.
+ * a single JSON object. tokens must have room for every token in the string.
  */
 int jsmn_parse(jsmn_parser *parser, const char *js, size_t len,
 		jsmntok_t *tokens, unsigned int num_tokens);
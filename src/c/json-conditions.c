@@ -0,0 +1,170 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "json.h"
+#include "json-conditions.h"
+
+// Conditions that hold on the platform being built. Display sizes are written "WxH"
+// and checked separately, and any condition can be negated with a leading '!'.
+static const char *s_conditions[] = {
+#ifdef PBL_ROUND
+    "round",
+#else
+    "rect",
+#endif
+#ifdef PBL_COLOR
+    "color",
+#else
+    "bw",
+#endif
+#if defined(PBL_PLATFORM_APLITE)
+    "aplite",
+#elif defined(PBL_PLATFORM_BASALT)
+    "basalt",
+#elif defined(PBL_PLATFORM_CHALK)
+    "chalk",
+#elif defined(PBL_PLATFORM_DIORITE)
+    "diorite",
+#elif defined(PBL_PLATFORM_EMERY)
+    "emery",
+#endif
+    NULL
+};
+
+struct Filter {
+    const char *s;
+    JsonToken *tokens;
+    int16_t w;
+};
+
+static bool prv_eq(const char *s, size_t len, const char *name) {
+    logf();
+    return strncmp(s, name, len) == 0 && name[len] == '\0';
+}
+
+bool json_condition_holds(const char *s, size_t len) {
+    logf();
+    bool negate = len > 0 && s[0] == '!';
+    if (negate) {
+        s++;
+        len--;
+    }
+    bool holds = false;
+    for (int i = 0; !holds && s_conditions[i]; i++) holds = prv_eq(s, len, s_conditions[i]);
+    if (!holds && len > 2 && s[0] >= '0' && s[0] <= '9') {
+        size_t x = 0;
+        while (x < len && s[x] != 'x') x++;
+        holds = x < len - 1 && json_parse_int(s, x) == PBL_DISPLAY_WIDTH &&
+            json_parse_int(s + x + 1, len - x - 1) == PBL_DISPLAY_HEIGHT;
+    }
+    return holds != negate;
+}
+
+// Length of a key up to its '@', or the whole key if it has no condition.
+static uint16_t prv_base_len(struct Filter *this, JsonToken *key) {
+    logf();
+    const char *at = memchr(this->s + key->start, '@', key->len);
+    return at ? at - (this->s + key->start) : key->len;
+}
+
+static bool prv_is_if(struct Filter *this, JsonToken *key) {
+    logf();
+    return key->len == 2 && strncmp(this->s + key->start, "if", 2) == 0;
+}
+
+// Whether a conditional member that holds has the same name as the plain key.
+static bool prv_overridden(struct Filter *this, int16_t object, JsonToken *key) {
+    logf();
+    int16_t member = object + 1;
+    for (int i = 0; i < this->tokens[object].size; i++, member = this->tokens[member + 1].next) {
+        JsonToken *other = &this->tokens[member];
+        uint16_t base = prv_base_len(this, other);
+        if (base == other->len || base != key->len) continue;
+        if (strncmp(this->s + other->start, this->s + key->start, base) != 0) continue;
+        if (json_condition_holds(this->s + other->start + base + 1, other->len - base - 1)) return true;
+    }
+    return false;
+}
+
+// Marks the members an object loses by setting their key's type to JSON_UNDEFINED, before
+// anything is moved. Returns false if its "if" does not hold and the whole object goes.
+static bool prv_mark_object(struct Filter *this, int16_t object) {
+    logf();
+    JsonToken *tokens = this->tokens;
+    bool conditional = false;
+    int16_t member = object + 1;
+    for (int i = 0; i < tokens[object].size; i++, member = tokens[member + 1].next) {
+        JsonToken *key = &tokens[member];
+        if (prv_is_if(this, key)) {
+            JsonToken *value = &tokens[member + 1];
+            if (!json_condition_holds(this->s + value->start, value->len)) return false;
+            key->type = JSON_UNDEFINED;
+        } else if (prv_base_len(this, key) != key->len) {
+            conditional = true;
+        }
+    }
+    if (!conditional) return true;
+
+    member = object + 1;
+    for (int i = 0; i < tokens[object].size; i++, member = tokens[member + 1].next) {
+        JsonToken *key = &tokens[member];
+        if (key->type == JSON_UNDEFINED) continue;
+        uint16_t base = prv_base_len(this, key);
+        bool keep = base == key->len ? !prv_overridden(this, object, key) :
+            json_condition_holds(this->s + key->start + base + 1, key->len - base - 1);
+        if (!keep) key->type = JSON_UNDEFINED;
+    }
+    return true;
+}
+
+// Copies the tree at r down to this->w, leaving out what lost, and rebuilds sizes and
+// subtree ends as it goes. Writes never pass reads, so this works in place.
+static bool prv_filter(struct Filter *this, int16_t r) {
+    logf();
+    JsonToken *tokens = this->tokens;
+    JsonToken tok = tokens[r];
+    if (tok.type == JSON_OBJECT && !prv_mark_object(this, r)) return false;
+
+    int16_t out = this->w++;
+    int count = 0;
+    int16_t child = r + 1;
+    for (int i = 0; i < tok.size; i++) {
+        // A key's subtree is its value, so members are stepped over through the value.
+        int16_t next = tok.type == JSON_ARRAY ? tokens[child].next : tokens[child + 1].next;
+        if (tok.type == JSON_ARRAY) {
+            if (prv_filter(this, child)) count++;
+        } else if (tokens[child].type != JSON_UNDEFINED) {
+            JsonToken key = tokens[child];
+            int16_t key_out = this->w++;
+            key.len = prv_base_len(this, &key);
+#ifndef JSON_PACKED_TOKENS
+            key.end = key.start + key.len;
+#endif
+            key.next = key_out + 1;
+            tokens[key_out] = key;
+            if (prv_filter(this, child + 1)) {
+                count++;
+            } else {
+                this->w = key_out;
+            }
+        }
+        child = next;
+    }
+
+    tok.size = count;
+    tok.next = this->w;
+    tokens[out] = tok;
+    return true;
+}
+
+int16_t json_resolve_conditions(const char *s, JsonToken *tokens, int16_t num_tokens) {
+    logf();
+    if (num_tokens == 0) return 0;
+    struct Filter filter = {
+        .s = s,
+        .tokens = tokens,
+        .w = 0
+    };
+    if (!prv_filter(&filter, 0)) return 0;
+    return filter.w;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <pebble.h>
+#include "json.h"
+
+bool json_condition_holds(const char *s, size_t len);
+int16_t json_resolve_conditions(const char *s, JsonToken *tokens, int16_t num_tokens);
@@ -0,0 +1,179 @@
+#include <pebble.h>
+#include "logging.h"
+#include "json-stream.h"
+
+#define JSON_STREAM_MAX_DEPTH 32
+#define JSON_STREAM_MAX_PRIMITIVE 15
+
+struct JsonStream {
+    ResHandle handle;
+    uint32_t size;
+    uint32_t offset;
+    char *window;
+    uint16_t window_size;
+    uint16_t pos;
+    uint16_t len;
+    uint8_t depth;
+    uint32_t objects;
+    bool key_next;
+    const char *text;
+    uint16_t text_len;
+    char primitive[JSON_STREAM_MAX_PRIMITIVE + 1];
+};
+
+JsonStream *json_stream_create_with_resource(uint32_t resource_id, uint16_t window_size) {
+    logf();
+    JsonStream *this = malloc(sizeof(JsonStream));
+    this->handle = resource_get_handle(resource_id);
+    this->size = resource_size(this->handle);
+    this->offset = 0;
+    this->window = malloc(window_size);
+    this->window_size = window_size;
+    this->pos = 0;
+    this->len = 0;
+    this->depth = 0;
+    this->objects = 0;
+    this->key_next = false;
+    this->text = NULL;
+    this->text_len = 0;
+    return this;
+}
+
+void json_stream_destroy(JsonStream *this) {
+    logf();
+    free(this->window);
+    this->window = NULL;
+    free(this);
+}
+
+// Drops everything before keep, slides the rest to the front of the window and loads as
+// much of the resource as fits behind it. Returns how far the window contents moved.
+static uint16_t prv_fill(JsonStream *this, uint16_t keep) {
+    logf();
+    memmove(this->window, this->window + keep, this->len - keep);
+    this->offset += keep;
+    this->pos -= keep;
+    this->len -= keep;
+
+    uint32_t loaded = this->offset + this->len;
+    uint32_t n = this->window_size - this->len;
+    if (n > this->size - loaded) n = this->size - loaded;
+    if (n > 0) {
+        this->len += resource_load_byte_range(this->handle, loaded, (uint8_t *) this->window + this->len, n);
+    }
+    return keep;
+}
+
+static bool prv_available(JsonStream *this) {
+    logf();
+    if (this->pos == this->len) prv_fill(this, this->pos);
+    return this->pos < this->len;
+}
+
+static JsonEvent prv_string(JsonStream *this) {
+    logf();
+    uint16_t start = ++this->pos;
+    bool escaped = false;
+    for (;;) {
+        if (this->pos == this->len) {
+            if (start == 0 && this->len == this->window_size) {
+                loge("json string longer than %d bytes", this->window_size - 1);
+                return JsonEventError;
+            }
+            start -= prv_fill(this, start);
+            if (this->pos == this->len) return JsonEventError;
+        }
+        char c = this->window[this->pos];
+        if (c == '"' && !escaped) break;
+        // A backslash and the character it escapes can be read into different windows.
+        escaped = c == '\\' && !escaped;
+        this->pos++;
+    }
+    this->window[this->pos++] = '\0';
+    this->text = this->window + start;
+    this->text_len = this->pos - 1 - start;
+    return JsonEventString;
+}
+
+static JsonEvent prv_primitive(JsonStream *this) {
+    logf();
+    uint16_t n = 0;
+    while (prv_available(this)) {
+        char c = this->window[this->pos];
+        if (c == ',' || c == ']' || c == '}' || c == ':' || c == ' ' || c == '\t' || c == '\r' || c == '\n') break;
+        if (n == JSON_STREAM_MAX_PRIMITIVE) return JsonEventError;
+        this->primitive[n++] = c;
+        this->pos++;
+    }
+    this->primitive[n] = '\0';
+    this->text = this->primitive;
+    this->text_len = n;
+    return JsonEventPrimitive;
+}
+
+static bool prv_in_object(JsonStream *this) {
+    logf();
+    return this->depth > 0 && (this->objects & (1u << (this->depth - 1)));
+}
+
+JsonEvent json_stream_next(JsonStream *this) {
+    logf();
+    while (prv_available(this)) {
+        char c = this->window[this->pos];
+        switch (c) {
+            case ' ': case '\t': case '\r': case '\n':
+                this->pos++;
+                break;
+            case ',':
+                this->key_next = prv_in_object(this);
+                this->pos++;
+                break;
+            case ':':
+                this->key_next = false;
+                this->pos++;
+                break;
+            case '{': case '[':
+                if (this->depth == JSON_STREAM_MAX_DEPTH) return JsonEventError;
+                if (c == '{') this->objects |= 1u << this->depth;
+                else this->objects &= ~(1u << this->depth);
+                this->depth++;
+                this->key_next = c == '{';
+                this->pos++;
+                return c == '{' ? JsonEventObjectStart : JsonEventArrayStart;
+            case '}': case ']':
+                if (this->depth == 0 || prv_in_object(this) != (c == '}')) return JsonEventError;
+                this->depth--;
+                this->key_next = false;
+                this->pos++;
+                return c == '}' ? JsonEventObjectEnd : JsonEventArrayEnd;
+            case '"': {
+                bool key = this->key_next;
+                if (prv_string(this) == JsonEventError) return JsonEventError;
+                return key ? JsonEventKey : JsonEventString;
+            }
+            default:
+                return prv_primitive(this);
+        }
+    }
+    return this->depth == 0 ? JsonEventEnd : JsonEventError;
+}
+
+const char *json_stream_text(JsonStream *this) {
+    logf();
+    return this->text;
+}
+
+uint16_t json_stream_len(JsonStream *this) {
+    logf();
+    return this->text_len;
+}
+
+void json_stream_skip(JsonStream *this, JsonEvent event) {
+    logf();
+    if (event != JsonEventObjectStart && event != JsonEventArrayStart) return;
+    uint8_t depth = this->depth - 1;
+    while (this->depth > depth) {
+        event = json_stream_next(this);
+        if (event == JsonEventError || event == JsonEventEnd) return;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <pebble.h>
+
+typedef struct JsonStream JsonStream;
+
+typedef enum {
+    JsonEventError = 0,
+    JsonEventEnd,
+    JsonEventObjectStart,
+    JsonEventObjectEnd,
+    JsonEventArrayStart,
+    JsonEventArrayEnd,
+    JsonEventKey,
+    JsonEventString,
+    JsonEventPrimitive
+} JsonEvent;
+
+JsonStream *json_stream_create_with_resource(uint32_t resource_id, uint16_t window_size);
+void json_stream_destroy(JsonStream *this);
+JsonEvent json_stream_next(JsonStream *this);
+const char *json_stream_text(JsonStream *this);
+uint16_t json_stream_len(JsonStream *this);
+void json_stream_skip(JsonStream *this, JsonEvent event);
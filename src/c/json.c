@@ -3,50 +3,119 @@
 #include "string.h"
 #include "logging.h"
 #include "json.h"
+#include "json-conditions.h"
 
 struct Json {
     char *buf;
     JsonToken *tokens;
     int16_t num_tokens;
     int16_t index;
+    // Allocated sizes, for layout_get_stats().
+    size_t buf_size;
+    int max_tokens;
 };
 
-Json *json_create_with_resource(uint32_t resource_id) {
+static bool prv_is_value(JsonToken *tok) {
+    logf();
+    return tok->type == JSON_STRING || tok->type == JSON_PRIMITIVE;
+}
+
+char *json_load_resource(uint32_t resource_id) {
     logf();
     ResHandle res_handle = resource_get_handle(resource_id);
     size_t res_size = resource_size(res_handle);
     char *json = malloc(sizeof(char) * (res_size + 1));
     resource_load(res_handle, (uint8_t *) json, res_size);
     json[res_size] = '\0';
-    return json_create(json);
+    return json;
+}
+
+Json *json_create_with_resource(uint32_t resource_id) {
+    logf();
+    return json_create(json_load_resource(resource_id));
 }
 
 Json *json_create(char *s) {
     logf();
     Json *this = malloc(sizeof(Json));
     this->buf = s;
+    this->index = 0;
+    this->buf_size = 0;
+    this->max_tokens = 0;
+
+    // Every token except the outermost one follows its own '{', '[', ',' or ':',
+    // so counting those bounds the token table without a separate jsmn pass.
+    // Conditions only matter in member names, so the same pass notes whether the string
+    // before a ':' was "if" or had an '@' in it.
+    size_t len = 0;
+    int max_tokens = 1;
+    bool conditional = false;
+    bool in_string = false;
+    bool escaped = false;
+    bool conditional_key = false;
+    size_t string_start = 0;
+    for (char c; (c = s[len]) != '\0'; len++) {
+        if (c == '{' || c == '[' || c == ',' || c == ':') max_tokens++;
+        if (in_string) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '@') {
+                conditional_key = true;
+            } else if (c == '"') {
+                in_string = false;
+                if (len - string_start == 3 && strncmp(s + string_start, "\"if", 3) == 0) conditional_key = true;
+            }
+        } else if (c == '"') {
+            in_string = true;
+            string_start = len;
+            conditional_key = false;
+        } else if (c == ':' && conditional_key) {
+            conditional = true;
+        }
+    }
+
+#ifdef JSON_PACKED_TOKENS
+    if (len > UINT16_MAX) {
+        loge("json too large for packed tokens: %d bytes", (int) len);
+        this->tokens = NULL;
+        this->num_tokens = 0;
+        this->buf_size = len + 1;
+        return this;
+    }
+#endif
 
     jsmn_parser parser;
     jsmn_init(&parser);
 
-    int num_tokens = jsmn_parse(&parser, s, strlen(s), NULL, 0);
-    jsmn_init(&parser);
-    jsmntok_t *tokens = malloc(sizeof(jsmntok_t) * num_tokens);
-    this->num_tokens = jsmn_parse(&parser, s, strlen(s), tokens, num_tokens);
-    this->index = 0;
+    this->tokens = malloc(sizeof(JsonToken) * max_tokens);
+    this->buf_size = len + 1;
+    this->max_tokens = max_tokens;
+    int num_tokens = jsmn_parse(&parser, s, len, this->tokens, max_tokens);
+    if (num_tokens < 0) {
+        loge("failed to parse json: %d", num_tokens);
+        num_tokens = 0;
+    }
 
-    this->tokens = malloc(sizeof(JsonToken) * this->num_tokens);
-    for (int i = 0; i < this->num_tokens; i++) {
-        jsmntok_t *tok = &tokens[i];
-        JsonToken *js_tok = &this->tokens[i];
-        js_tok->type = tok->type;
-        js_tok->start = tok->start;
-        js_tok->end = tok->end;
-        js_tok->len = tok->end - tok->start;
-        js_tok->size = tok->size;
+    // Members and objects for other platforms are dropped before anything reads them, and
+    // the table shrinks to what is left.
+    if (conditional && num_tokens > 0) {
+        num_tokens = json_resolve_conditions(s, this->tokens, num_tokens);
+        JsonToken *tokens = realloc(this->tokens, sizeof(JsonToken) * (num_tokens ? num_tokens : 1));
+        if (tokens) {
+            this->tokens = tokens;
+            this->max_tokens = num_tokens ? num_tokens : 1;
+        }
     }
+    this->num_tokens = num_tokens;
 
-    free(tokens);
+    // The character after a string or primitive is always a quote or delimiter that
+    // tokenizing no longer needs, so terminate values in place and hand out views.
+    for (int i = 0; i < num_tokens; i++) {
+        JsonToken *tok = &this->tokens[i];
+        if (tok->type == JSON_STRING || tok->type == JSON_PRIMITIVE) s[tok->start + tok->len] = '\0';
+    }
 
     return this;
 }
@@ -81,20 +150,121 @@ char *json_next_string(Json *this) {
     return strndup(this->buf + tok->start, tok->len);
 }
 
+const char *json_next_string_view(Json *this) {
+    logf();
+    JsonToken *tok = json_next(this);
+    if (!prv_is_value(tok)) return NULL;
+    return this->buf + tok->start;
+}
+
+char *json_detach_buffer(Json *this) {
+    logf();
+    char *buf = this->buf;
+    this->buf = NULL;
+    return buf;
+}
+
+size_t json_get_text_size(Json *this) {
+    logf();
+    return this->buf_size;
+}
+
+size_t json_get_heap_size(Json *this) {
+    logf();
+    return sizeof(Json) + (this->buf ? this->buf_size : 0) + sizeof(JsonToken) * this->max_tokens;
+}
+
+static int32_t prv_parse_whole(const char *s, size_t len, size_t *i, bool *negative) {
+    logf();
+    *negative = false;
+    if (*i < len && (s[*i] == '-' || s[*i] == '+')) *negative = s[(*i)++] == '-';
+
+    int32_t whole = 0;
+    for (; *i < len && s[*i] >= '0' && s[*i] <= '9'; (*i)++) whole = whole * 10 + (s[*i] - '0');
+    return whole;
+}
+
+int json_parse_int(const char *s, size_t len) {
+    logf();
+    // Like atoi(), any fraction is truncated.
+    size_t i = 0;
+    bool negative;
+    int32_t whole = prv_parse_whole(s, len, &i, &negative);
+    return negative ? -whole : whole;
+}
+
+int32_t json_parse_fixed(const char *s, size_t len, uint8_t fraction_bits) {
+    logf();
+    size_t i = 0;
+    bool negative;
+    int32_t whole = prv_parse_whole(s, len, &i, &negative);
+
+    // Up to four fraction digits are kept, which is finer than any fixed-point type Pebble uses.
+    int32_t fraction = 0;
+    int32_t scale = 1;
+    if (i < len && s[i] == '.') {
+        for (i++; i < len && s[i] >= '0' && s[i] <= '9'; i++) {
+            if (scale == 10000) continue;
+            fraction = fraction * 10 + (s[i] - '0');
+            scale *= 10;
+        }
+    }
+
+    int32_t value = whole * (1 << fraction_bits) + (fraction * (1 << fraction_bits) + scale / 2) / scale;
+    return negative ? -value : value;
+}
+
+bool json_parse_bool(const char *s, size_t len) {
+    logf();
+    return len == 4 && strncmp(s, "true", 4) == 0;
+}
+
+GColor json_parse_gcolor(const char *s, size_t len) {
+    logf();
+    size_t i = 0;
+    if (i < len && s[i] == '#') i++;
+    else if (len >= 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) i = 2;
+
+    uint32_t rgb = 0;
+    for (; i < len; i++) {
+        char c = s[i];
+        if (c >= '0' && c <= '9') rgb = (rgb << 4) | (c - '0');
+        else if (c >= 'a' && c <= 'f') rgb = (rgb << 4) | (c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') rgb = (rgb << 4) | (c - 'A' + 10);
+        else break;
+    }
+    return GColorFromHEX(rgb);
+}
+
+GRect json_parse_grect(const char *s, size_t len) {
+    logf();
+    // "x, y, w, h", with or without the brackets of a JSON array.
+    int16_t values[4] = { 0 };
+    size_t i = 0;
+    for (uint n = 0; n < ARRAY_LENGTH(values); n++) {
+        while (i < len && (s[i] == ' ' || s[i] == ',' || s[i] == '[')) i++;
+        values[n] = json_parse_int(s + i, len - i);
+        while (i < len && s[i] != ',') i++;
+    }
+    return GRect(values[0], values[1], values[2], values[3]);
+}
+
 int json_next_int(Json *this) {
     logf();
-    char *s = json_next_string(this);
-    int i = atoi(s);
-    free(s);
-    return i;
+    JsonToken *tok = json_next(this);
+    return prv_is_value(tok) ? json_parse_int(this->buf + tok->start, tok->len) : 0;
+}
+
+int32_t json_next_fixed(Json *this, uint8_t fraction_bits) {
+    logf();
+    JsonToken *tok = json_next(this);
+    return prv_is_value(tok) ? json_parse_fixed(this->buf + tok->start, tok->len, fraction_bits) : 0;
 }
 
 bool json_next_bool(Json *this) {
     logf();
     JsonToken *tok = json_next(this);
-    return tok->type == JSON_PRIMITIVE && \
-           (int) strlen("true") == tok->len && \
-           strncmp(this->buf + tok->start, "true", tok->len) == 0;
+    return tok->type == JSON_PRIMITIVE && json_parse_bool(this->buf + tok->start, tok->len);
 }
 
 GRect json_next_grect(Json *this) {
@@ -111,25 +281,59 @@ GRect json_next_grect(Json *this) {
 
 GColor json_next_gcolor(Json *this) {
     logf();
-    char *s = json_next_string(this);
-    GColor color = GColorFromHEX(strtoul(s + (s[0] == '#' ? 1 : 0), NULL, 16));
-    free(s);
-    return color;
+    JsonToken *tok = json_next(this);
+    return prv_is_value(tok) ? json_parse_gcolor(this->buf + tok->start, tok->len) : GColorFromHEX(0);
 }
 
 void json_skip_tree(Json *this) {
     logf();
-    JsonToken *tok = json_next(this);
-    if (tok->type == JSON_ARRAY) {
-        int size = tok->size;
-        for (int i = 0; i < size; i++) json_skip_tree(this);
-    } else if (tok->type == JSON_OBJECT) {
-        int size = tok->size;
-        for (int i = 0; i < size; i++) {
-            tok = json_next(this);
-            json_skip_tree(this);
-        }
+    this->index = this->tokens[this->index].next;
+}
+
+Json *json_copy_tree(Json *this) {
+    logf();
+    int16_t first = this->index;
+    JsonToken *root = &this->tokens[first];
+    int16_t count = root->next - first;
+
+    Json *copy = malloc(sizeof(Json));
+    copy->buf = malloc(root->len + 1);
+    memcpy(copy->buf, this->buf + root->start, root->len);
+    copy->buf[root->len] = '\0';
+    copy->tokens = malloc(sizeof(JsonToken) * count);
+    copy->num_tokens = count;
+    copy->index = 0;
+    copy->buf_size = root->len + 1;
+    copy->max_tokens = count;
+
+    // Values in the text are already terminated in place, so the copy only needs its
+    // offsets and subtree ends rebased.
+    for (int16_t i = 0; i < count; i++) {
+        JsonToken *tok = &copy->tokens[i];
+        *tok = this->tokens[first + i];
+        tok->start -= root->start;
+#ifndef JSON_PACKED_TOKENS
+        tok->end -= root->start;
+#endif
+        tok->next -= first;
     }
+
+    this->index = root->next;
+    return copy;
+}
+
+int16_t json_get_num_tokens(Json *this) {
+    logf();
+    return this->num_tokens;
+}
+
+int16_t json_get_num_objects(Json *this) {
+    logf();
+    int16_t count = 0;
+    for (int i = 0; i < this->num_tokens; i++) {
+        if (this->tokens[i].type == JSON_OBJECT) count++;
+    }
+    return count;
 }
 
 int16_t json_get_index(Json *this) {
@@ -148,3 +352,8 @@ bool json_eq(Json *this, JsonToken *tok, const char *s) {
            (int) strlen(s) == tok->len && \
            strncmp(this->buf + tok->start, s, tok->len) == 0;
 }
+
+const char *json_token_text(Json *this, JsonToken *tok) {
+    logf();
+    return this->buf + tok->start;
+}
@@ -0,0 +1,319 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+// Must match tools/layout_compiler.py
+#define BINARY_VERSION 1
+#define BINARY_NONE 0xFFFF
+#define BINARY_FLAG_ID (1 << 0)
+#define BINARY_FLAG_FRAME (1 << 1)
+
+typedef enum {
+    BinaryTagBool = 1,
+    BinaryTagInt,
+    BinaryTagColor,
+    BinaryTagString,
+    BinaryTagEnum,
+    BinaryTagRect,
+    BinaryTagLayers
+} BinaryTag;
+
+struct Binary {
+    Layout *layout;
+    const uint8_t *data;
+    size_t size;
+    size_t pos;
+    bool error;
+    uint16_t num_strings;
+    const uint8_t *hashes;
+    const uint8_t *offsets;
+    const char *strings;
+    uint16_t strings_size;
+    struct LayoutType **types;
+};
+
+struct BinaryValue {
+    uint8_t tag;
+    int32_t integer;
+    uint16_t string;
+    GRect rect;
+};
+
+static const uint8_t *prv_read(struct Binary *this, size_t n) {
+    logf();
+    if (this->error || this->size - this->pos < n) {
+        this->error = true;
+        return NULL;
+    }
+    const uint8_t *p = this->data + this->pos;
+    this->pos += n;
+    return p;
+}
+
+static uint8_t prv_read_u8(struct Binary *this) {
+    logf();
+    const uint8_t *p = prv_read(this, 1);
+    return p ? p[0] : 0;
+}
+
+static uint16_t prv_get_u16(const uint8_t *p) {
+    logf();
+    return p[0] | (p[1] << 8);
+}
+
+static uint16_t prv_read_u16(struct Binary *this) {
+    logf();
+    const uint8_t *p = prv_read(this, 2);
+    return p ? prv_get_u16(p) : 0;
+}
+
+static uint32_t prv_get_u32(const uint8_t *p) {
+    logf();
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static int32_t prv_read_i32(struct Binary *this) {
+    logf();
+    const uint8_t *p = prv_read(this, 4);
+    return p ? (int32_t) prv_get_u32(p) : 0;
+}
+
+static GRect prv_read_rect(struct Binary *this) {
+    logf();
+    int16_t values[4];
+    for (uint i = 0; i < ARRAY_LENGTH(values); i++) {
+        values[i] = (int16_t) prv_read_u16(this);
+    }
+    return GRect(values[0], values[1], values[2], values[3]);
+}
+
+static const char *prv_string(struct Binary *this, uint16_t index) {
+    logf();
+    if (index >= this->num_strings) {
+        this->error = true;
+        return NULL;
+    }
+    uint16_t offset = prv_get_u16(this->offsets + index * 2);
+    if (offset >= this->strings_size) {
+        this->error = true;
+        return NULL;
+    }
+    return this->strings + offset;
+}
+
+static uint32_t prv_hash(struct Binary *this, uint16_t index) {
+    logf();
+    return prv_get_u32(this->hashes + index * 4);
+}
+
+static bool prv_read_header(struct Binary *this) {
+    logf();
+    const uint8_t *magic = prv_read(this, 4);
+    if (!magic || memcmp(magic, "PLYT", 4) != 0) return false;
+    if (prv_read_u8(this) != BINARY_VERSION) return false;
+    prv_read_u8(this);
+    this->num_strings = prv_read_u16(this);
+    this->strings_size = prv_read_u16(this);
+    this->hashes = prv_read(this, this->num_strings * 4);
+    this->offsets = prv_read(this, this->num_strings * 2);
+    this->strings = (const char *) prv_read(this, this->strings_size);
+    if (this->error) return false;
+    if (this->strings_size > 0 && this->strings[this->strings_size - 1] != '\0') return false;
+    this->types = calloc(this->num_strings, sizeof(struct LayoutType *));
+    return true;
+}
+
+static void prv_read_value(struct Binary *this, struct BinaryValue *value) {
+    logf();
+    value->tag = prv_read_u8(this);
+    switch (value->tag) {
+        case BinaryTagBool:
+        case BinaryTagColor:
+            value->integer = prv_read_u8(this);
+            break;
+        case BinaryTagInt:
+        case BinaryTagEnum:
+            value->integer = prv_read_i32(this);
+            break;
+        case BinaryTagString:
+            value->string = prv_read_u16(this);
+            break;
+        case BinaryTagRect:
+            value->rect = prv_read_rect(this);
+            break;
+        case BinaryTagLayers:
+            value->integer = prv_read_u16(this);
+            break;
+        default:
+            this->error = true;
+            break;
+    }
+}
+
+static void prv_skip_node(struct Binary *this) {
+    logf();
+    prv_read_u16(this);
+    uint8_t flags = prv_read_u8(this);
+    uint8_t count = prv_read_u8(this);
+    if (flags & BINARY_FLAG_ID) prv_read_u16(this);
+    if (flags & BINARY_FLAG_FRAME) prv_read_rect(this);
+    for (int i = 0; i < count && !this->error; i++) {
+        struct BinaryValue value;
+        prv_read_u16(this);
+        prv_read_value(this, &value);
+        if (value.tag != BinaryTagLayers) continue;
+        for (int j = 0; j < value.integer && !this->error; j++) prv_skip_node(this);
+    }
+}
+
+static struct LayoutType *prv_type(struct Binary *this, uint16_t index) {
+    logf();
+    if (index == BINARY_NONE) return layout_get_type(this->layout, NULL);
+    const char *name = prv_string(this, index);
+    if (!name) return layout_get_type(this->layout, NULL);
+    if (!this->types[index]) {
+        struct LayoutType *type = layout_get_type(this->layout, (char *) name);
+        if (!type->funcs.properties) {
+            logw("%s has no property schema, using Layer", name);
+            type = layout_get_type(this->layout, NULL);
+        }
+        this->types[index] = type;
+    }
+    return this->types[index];
+}
+
+static Layer *prv_read_node(struct Binary *this);
+
+static void prv_apply_property(struct Binary *this, struct LayoutType *type, int index, void *object,
+        struct BinaryValue *binary) {
+    logf();
+    Layout *layout = this->layout;
+    const LayoutProperty *property = &type->funcs.properties[index];
+    const char *s = binary->tag == BinaryTagString ? prv_string(this, binary->string) : NULL;
+    LayoutValue value;
+
+    if (binary->tag == BinaryTagLayers) {
+        for (int i = 0; i < binary->integer && !this->error; i++) {
+            if (property->kind != LayoutPropertyLayers) {
+                prv_skip_node(this);
+                continue;
+            }
+            value.layer = prv_read_node(this);
+            if (value.layer) property->set(layout, object, value);
+        }
+        return;
+    }
+
+    switch (property->kind) {
+        case LayoutPropertyBool:
+        case LayoutPropertyInt:
+            if (binary->tag != BinaryTagBool && binary->tag != BinaryTagInt && binary->tag != BinaryTagEnum) return;
+            if (property->kind == LayoutPropertyBool) value.boolean = binary->integer != 0;
+            else value.integer = binary->integer;
+            break;
+        case LayoutPropertyColor:
+            if (binary->tag == BinaryTagColor) {
+                value.color = (GColor) { .argb = binary->integer };
+            } else if (s) {
+                value.color = json_parse_gcolor(s, strlen(s));
+            } else {
+                return;
+            }
+            break;
+        case LayoutPropertyString:
+            if (!s) return;
+            value.string = layout_keep_string(layout, s);
+            break;
+        case LayoutPropertyEnum:
+            if (binary->tag == BinaryTagEnum || binary->tag == BinaryTagInt) {
+                value.integer = binary->integer;
+            } else if (s) {
+                value.integer = layout_type_enum_value(type, index, prv_hash(this, binary->string), s, strlen(s));
+            } else {
+                return;
+            }
+            break;
+        case LayoutPropertyFont:
+            if (!s) return;
+            value.font = layout_get_font(layout, (char *) s);
+            if (!value.font) return;
+            break;
+        case LayoutPropertyResource: {
+            if (!s) return;
+            uint32_t *resource_id = layout_get_resource(layout, (char *) s);
+            if (!resource_id) return;
+            value.resource_id = *resource_id;
+            break;
+        }
+        case LayoutPropertyRect:
+            if (binary->tag != BinaryTagRect) return;
+            value.rect = binary->rect;
+            break;
+        default:
+            return;
+    }
+    property->set(layout, object, value);
+}
+
+static Layer *prv_read_node(struct Binary *this) {
+    logf();
+    struct LayoutType *type = prv_type(this, prv_read_u16(this));
+    uint8_t flags = prv_read_u8(this);
+    uint8_t count = prv_read_u8(this);
+    if (this->error) return NULL;
+
+    struct LayerData *data = layout_create_object(this->layout, type, NULL, NULL);
+    void *object = data->object;
+
+    if (flags & BINARY_FLAG_ID) {
+        const char *id = prv_string(this, prv_read_u16(this));
+        if (id) layout_set_id(this->layout, layout_keep_string(this->layout, id), data);
+    }
+    if (flags & BINARY_FLAG_FRAME) {
+        type->funcs.set_frame(object, prv_read_rect(this));
+    }
+
+    for (int i = 0; i < count && !this->error; i++) {
+        uint16_t key = prv_read_u16(this);
+        struct BinaryValue value;
+        prv_read_value(this, &value);
+        const char *name = prv_string(this, key);
+        if (this->error) break;
+
+        int property = layout_type_find_property(type, prv_hash(this, key), name, strlen(name));
+        if (property >= 0) {
+            prv_apply_property(this, type, property, object, &value);
+        } else if (value.tag == BinaryTagLayers) {
+            for (int j = 0; j < value.integer && !this->error; j++) prv_skip_node(this);
+        }
+    }
+
+    return type->funcs.get_layer(object);
+}
+
+void layout_parse_binary(Layout *this, uint32_t resource_id) {
+    logf();
+    layout_stats_begin_parse(this);
+    ResHandle res_handle = resource_get_handle(resource_id);
+    size_t res_size = resource_size(res_handle);
+    uint8_t *data = malloc(res_size);
+    resource_load(res_handle, data, res_size);
+
+    struct Binary binary = {
+        .layout = this,
+        .data = data,
+        .size = res_size
+    };
+    if (prv_read_header(&binary)) {
+        layout_set_root(this, prv_read_node(&binary));
+    } else {
+        binary.error = true;
+    }
+    if (binary.error) loge("invalid binary layout");
+
+    layout_stats_end_parse(this, NULL);
+    free(binary.types);
+    layout_keep_buffer(this, data, res_size);
+}
@@ -0,0 +1,212 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+#include "dict.h"
+#include "json.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+#ifndef LAYOUT_BINDING_SIZE
+#define LAYOUT_BINDING_SIZE 32
+#endif
+
+#define LAYOUT_BINDING_MAX_NAME 32
+
+// A property of one layer that shows a binding's value.
+struct BindingTarget {
+    struct LayerData *data;
+    uint8_t property;
+    struct BindingTarget *next;
+};
+
+// A named value declared as "{name}" or "{name:size}" in JSON. The value buffer is
+// allocated once in the layout's arena, and string properties point straight at it.
+struct Binding {
+    char *value;
+    uint16_t size;
+    bool dirty;
+    struct BindingTarget *targets;
+};
+
+struct Unbind {
+    Layout *layout;
+    struct LayerData *data;
+    int property;
+};
+
+static bool prv_is_name_char(char c) {
+    logf();
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+// Splits "{name}" or "{name:size}" into its name length and buffer size.
+static bool prv_parse_placeholder(const char *text, size_t len, size_t *name_len, uint16_t *size) {
+    logf();
+    if (len < 3 || text[0] != '{' || text[len - 1] != '}') return false;
+    size_t i = 1;
+    while (i < len - 1 && prv_is_name_char(text[i])) i++;
+    *name_len = i - 1;
+    if (*name_len == 0 || *name_len >= LAYOUT_BINDING_MAX_NAME) return false;
+    *size = LAYOUT_BINDING_SIZE;
+    if (i == len - 1) return true;
+    if (text[i] != ':' || i + 1 == len - 1) return false;
+    int n = 0;
+    for (i++; i < len - 1; i++) {
+        if (text[i] < '0' || text[i] > '9') return false;
+        n = n * 10 + (text[i] - '0');
+        if (n > UINT16_MAX) return false;
+    }
+    if (n < 2) return false;
+    *size = n;
+    return true;
+}
+
+bool layout_is_placeholder(const char *text, size_t len) {
+    logf();
+    size_t name_len = 0;
+    uint16_t size = 0;
+    return prv_parse_placeholder(text, len, &name_len, &size);
+}
+
+static void prv_apply_target(Layout *this, struct Binding *binding, struct BindingTarget *target) {
+    logf();
+    struct LayoutType *type = target->data->type;
+    const LayoutProperty *property = &type->funcs.properties[target->property];
+    LayoutValue value;
+    if (property->kind == LayoutPropertyString) {
+        value.string = binding->value;
+    } else if (!layout_decode_value(this, type, target->property, binding->value, &value)) {
+        return;
+    }
+    property->set(this, target->data->object, value);
+    layer_mark_dirty(type->funcs.get_layer(target->data->object));
+}
+
+static bool prv_flush_binding(char *key, void *value, void *context) {
+    logf();
+    Layout *this = (Layout *) context;
+    struct Binding *binding = (struct Binding *) value;
+    if (!binding->dirty) return true;
+    binding->dirty = false;
+    for (struct BindingTarget *target = binding->targets; target; target = target->next) {
+        prv_apply_target(this, binding, target);
+    }
+    return true;
+}
+
+static void prv_flush(void *context) {
+    logf();
+    Layout *this = (Layout *) context;
+    this->flush_timer = NULL;
+    dict_foreach(this->bindings, prv_flush_binding, this);
+}
+
+bool layout_bind(Layout *this, struct LayerData *data, int property, Json *json) {
+    logf();
+    int16_t index = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    const char *text = json_token_text(json, tok);
+    size_t name_len = 0;
+    uint16_t size = 0;
+    if (tok->type != JSON_STRING || !prv_parse_placeholder(text, tok->len, &name_len, &size)) {
+        json_set_index(json, index);
+        return false;
+    }
+
+    char name[LAYOUT_BINDING_MAX_NAME];
+    memcpy(name, text + 1, name_len);
+    name[name_len] = '\0';
+    struct Binding *binding = dict_get(this->bindings, name);
+    if (!binding) {
+        binding = arena_alloc(this->arena, sizeof(struct Binding));
+        binding->value = arena_alloc(this->arena, size);
+        binding->value[0] = '\0';
+        binding->size = size;
+        binding->dirty = false;
+        binding->targets = NULL;
+        dict_put(this->bindings, layout_copy_string(this, name, name_len), binding);
+    } else if (binding->size < size) {
+        char *value = arena_alloc(this->arena, size);
+        strcpy(value, binding->value);
+        binding->value = value;
+        binding->size = size;
+        // String properties still point at the old buffer.
+        binding->dirty = true;
+        if (!this->flush_timer) this->flush_timer = app_timer_register(0, prv_flush, this);
+    }
+
+    struct BindingTarget *target = this->free_targets;
+    if (target) {
+        this->free_targets = target->next;
+    } else {
+        target = arena_alloc(this->arena, sizeof(struct BindingTarget));
+    }
+    target->data = data;
+    target->property = property;
+    target->next = binding->targets;
+    binding->targets = target;
+    data->bound = true;
+
+    // A layer bound after the value was set shows it straight away. Until then strings are
+    // empty and other kinds keep their default.
+    if (data->type->funcs.properties[property].kind == LayoutPropertyString || binding->value[0]) {
+        prv_apply_target(this, binding, target);
+    }
+    return true;
+}
+
+static bool prv_unbind_callback(char *key, void *value, void *context) {
+    logf();
+    struct Binding *binding = (struct Binding *) value;
+    struct Unbind *unbind = (struct Unbind *) context;
+    struct BindingTarget **link = &binding->targets;
+    while (*link) {
+        struct BindingTarget *target = *link;
+        if (target->data == unbind->data && (unbind->property < 0 || target->property == unbind->property)) {
+            *link = target->next;
+            target->next = unbind->layout->free_targets;
+            unbind->layout->free_targets = target;
+        } else {
+            link = &(*link)->next;
+        }
+    }
+    return true;
+}
+
+void layout_unbind(Layout *this, struct LayerData *data, int property) {
+    logf();
+    struct Unbind unbind = { .layout = this, .data = data, .property = property };
+    dict_foreach(this->bindings, prv_unbind_callback, &unbind);
+}
+
+void layout_bindings_destroy(Layout *this) {
+    logf();
+    if (this->flush_timer) app_timer_cancel(this->flush_timer);
+    this->flush_timer = NULL;
+    // Bindings and their buffers live in the arena.
+    dict_destroy(this->bindings);
+    this->bindings = NULL;
+}
+
+void layout_set_value(Layout *this, const char *name, const char *value) {
+    logf();
+    struct Binding *binding = dict_get(this->bindings, (char *) name);
+    if (!binding) {
+        logw("no binding named %s", name);
+        return;
+    }
+    // The buffer holds at most size - 1 characters, so compare what would be stored.
+    if (strncmp(binding->value, value, binding->size - 1) == 0) return;
+    strncpy(binding->value, value, binding->size - 1);
+    binding->value[binding->size - 1] = '\0';
+    binding->dirty = true;
+    if (!this->flush_timer) this->flush_timer = app_timer_register(0, prv_flush, this);
+}
+
+void layout_set_value_int(Layout *this, const char *name, int value) {
+    logf();
+    char text[12];
+    snprintf(text, sizeof(text), "%d", value);
+    layout_set_value(this, name, text);
+}
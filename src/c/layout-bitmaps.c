@@ -0,0 +1,113 @@
+#include <pebble.h>
+#include "logging.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+// One entry per resource that is loaded or pinned, shared by every layout in the app.
+struct BitmapEntry {
+    uint32_t resource_id;
+    GBitmap *bitmap;
+    size_t bytes;
+    uint16_t refs;
+    bool keep_alive;
+};
+
+static struct BitmapEntry *s_entries = NULL;
+static uint16_t s_count = 0;
+static uint16_t s_capacity = 0;
+
+static struct BitmapEntry *prv_find_id(uint32_t resource_id) {
+    logf();
+    for (uint16_t i = 0; i < s_count; i++) {
+        if (s_entries[i].resource_id == resource_id) return &s_entries[i];
+    }
+    return NULL;
+}
+
+static struct BitmapEntry *prv_find_bitmap(GBitmap *bitmap) {
+    logf();
+    for (uint16_t i = 0; i < s_count; i++) {
+        if (s_entries[i].bitmap == bitmap) return &s_entries[i];
+    }
+    return NULL;
+}
+
+static struct BitmapEntry *prv_add(uint32_t resource_id) {
+    logf();
+    if (s_count == s_capacity) {
+        uint16_t capacity = s_capacity ? s_capacity * 2 : 4;
+        struct BitmapEntry *entries = realloc(s_entries, sizeof(struct BitmapEntry) * capacity);
+        if (!entries) return NULL;
+        s_entries = entries;
+        s_capacity = capacity;
+    }
+    struct BitmapEntry *entry = &s_entries[s_count++];
+    entry->resource_id = resource_id;
+    entry->bitmap = NULL;
+    entry->bytes = 0;
+    entry->refs = 0;
+    entry->keep_alive = false;
+    return entry;
+}
+
+static void prv_remove_if_unused(struct BitmapEntry *entry) {
+    logf();
+    if (entry->refs > 0 || entry->keep_alive) return;
+    if (entry->bitmap) gbitmap_destroy(entry->bitmap);
+    *entry = s_entries[--s_count];
+    if (s_count == 0) {
+        free(s_entries);
+        s_entries = NULL;
+        s_capacity = 0;
+    }
+}
+
+GBitmap *layout_bitmap_acquire(uint32_t resource_id) {
+    logf();
+    struct BitmapEntry *entry = prv_find_id(resource_id);
+    if (!entry) entry = prv_add(resource_id);
+    if (!entry) return NULL;
+    if (!entry->bitmap) {
+        size_t before = heap_bytes_used();
+        entry->bitmap = gbitmap_create_with_resource(resource_id);
+        size_t after = heap_bytes_used();
+        entry->bytes = after > before ? after - before : 0;
+    }
+    if (!entry->bitmap) {
+        prv_remove_if_unused(entry);
+        return NULL;
+    }
+    entry->refs++;
+    return entry->bitmap;
+}
+
+bool layout_bitmap_release(GBitmap *bitmap) {
+    logf();
+    struct BitmapEntry *entry = bitmap ? prv_find_bitmap(bitmap) : NULL;
+    if (!entry) return false;
+    if (entry->refs == 0) return true;
+    entry->refs--;
+    prv_remove_if_unused(entry);
+    return true;
+}
+
+void layout_bitmap_keep_alive(uint32_t resource_id, bool keep_alive) {
+    logf();
+    struct BitmapEntry *entry = prv_find_id(resource_id);
+    if (!entry && keep_alive) entry = prv_add(resource_id);
+    if (!entry) return;
+    entry->keep_alive = keep_alive;
+    prv_remove_if_unused(entry);
+}
+
+size_t layout_bitmap_get_stats(uint16_t *num_bitmaps) {
+    logf();
+    size_t bytes = s_capacity * sizeof(struct BitmapEntry);
+    *num_bitmaps = 0;
+    for (uint16_t i = 0; i < s_count; i++) {
+        if (!s_entries[i].bitmap) continue;
+        bytes += s_entries[i].bytes;
+        (*num_bitmaps)++;
+    }
+    return bytes;
+}
@@ -0,0 +1,332 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+#include "json.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+// A coordinate or size: a fixed number of pixels plus a percentage of the parent's size.
+struct Length {
+    int16_t value;
+    int16_t percent;
+};
+
+typedef enum {
+    BoxStackNone,
+    BoxStackVertical,
+    BoxStackHorizontal
+} BoxStack;
+
+// Layers with relative frames, anchors or stacks, and their parents, get a box that keeps
+// the frame as written so it can be resolved again when a size changes. Layers with plain
+// frames never get one and are positioned once, as before.
+struct Box {
+    struct LayerData *data;
+    struct Length x, y, w, h;
+    // 0 for left or top, 1 for center, 2 for right or bottom.
+    uint8_t anchor_x;
+    uint8_t anchor_y;
+    uint8_t stack;
+    // Holds a lazy layer's slot in a stack, taking no room until the layer is shown.
+    bool placeholder;
+    int16_t spacing;
+    GRect frame;
+    struct Box *parent;
+    struct Box *first;
+    struct Box *last;
+    struct Box *next;
+};
+
+static Layer *prv_get_layer(struct LayerData *data) {
+    logf();
+    return data->type->funcs.get_layer(data->object);
+}
+
+static struct Box *prv_ensure_box(Layout *this, struct LayerData *data) {
+    logf();
+    if (data->box) return data->box;
+    struct Box *box = this->free_boxes;
+    if (box) {
+        this->free_boxes = box->next;
+    } else {
+        box = arena_alloc(this->arena, sizeof(struct Box));
+    }
+    memset(box, 0, sizeof(struct Box));
+    box->data = data;
+    // Until a frame is read, keep whatever frame the layer already has.
+    GRect frame = layer_get_frame(prv_get_layer(data));
+    box->x.value = frame.origin.x;
+    box->y.value = frame.origin.y;
+    box->w.value = frame.size.w;
+    box->h.value = frame.size.h;
+    // An impossible size, so the first placement always arranges the children.
+    box->frame.size.w = -1;
+    data->box = box;
+    return box;
+}
+
+// Parses "12", "50%", "50%+4" or "100%-10".
+static struct Length prv_parse_length(const char *s, size_t len) {
+    logf();
+    struct Length length = { 0, 0 };
+    size_t i = 0;
+    while (i < len && s[i] != '%') i++;
+    if (i == len) {
+        length.value = json_parse_int(s, len);
+    } else {
+        length.percent = json_parse_int(s, i);
+        i++;
+        while (i < len && s[i] == ' ') i++;
+        if (i < len && s[i] == '+') i++;
+        if (i < len) length.value = json_parse_int(s + i, len - i);
+    }
+    return length;
+}
+
+static int16_t prv_resolve(struct Length length, int16_t total) {
+    logf();
+    return total * length.percent / 100 + length.value;
+}
+
+static bool prv_is_relative(struct Length *lengths) {
+    logf();
+    for (int i = 0; i < 4; i++) {
+        if (lengths[i].percent) return true;
+    }
+    return false;
+}
+
+static void prv_set_lengths(struct Box *box, struct Length *lengths) {
+    logf();
+    box->x = lengths[0];
+    box->y = lengths[1];
+    box->w = lengths[2];
+    box->h = lengths[3];
+}
+
+static GSize prv_parent_size(struct Box *box) {
+    logf();
+    if (box->parent) return box->parent->frame.size;
+    return GSize(PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT);
+}
+
+static void prv_arrange(Layout *this, struct Box *box);
+
+static void prv_place(Layout *this, struct Box *box, GRect frame) {
+    logf();
+    bool resized = !gsize_equal(&frame.size, &box->frame.size);
+    box->frame = frame;
+    box->data->type->funcs.set_frame(box->data->object, frame);
+    if (resized) prv_arrange(this, box);
+}
+
+static GRect prv_resolve_frame(struct Box *box, GSize parent) {
+    logf();
+    GRect frame;
+    frame.size.w = prv_resolve(box->w, parent.w);
+    frame.size.h = prv_resolve(box->h, parent.h);
+    frame.origin.x = (parent.w - frame.size.w) * box->anchor_x / 2 + prv_resolve(box->x, parent.w);
+    frame.origin.y = (parent.h - frame.size.h) * box->anchor_y / 2 + prv_resolve(box->y, parent.h);
+    // A root without a frame fills the screen, as it always has.
+    if (!box->parent && grect_equal(&frame, &GRectZero)) frame.size = parent;
+    return frame;
+}
+
+// Lays out the children of a box whose size is known. Children that end up the same
+// size are only moved, so nothing below them is recomputed.
+static void prv_arrange(Layout *this, struct Box *box) {
+    logf();
+    GSize size = box->frame.size;
+    int16_t cursor = 0;
+    for (struct Box *child = box->first; child; child = child->next) {
+        if (child->placeholder) continue;
+        GRect frame = prv_resolve_frame(child, size);
+        if (box->stack == BoxStackVertical) {
+            frame.origin.y = cursor + prv_resolve(child->y, size.h);
+            cursor = frame.origin.y + frame.size.h + box->spacing;
+        } else if (box->stack == BoxStackHorizontal) {
+            frame.origin.x = cursor + prv_resolve(child->x, size.w);
+            cursor = frame.origin.x + frame.size.w + box->spacing;
+        }
+        prv_place(this, child, frame);
+    }
+}
+
+static void prv_read_frame(Layout *this, struct LayerData *data, Json *json) {
+    logf();
+    layout_note_applied(data, 0);
+    int16_t index = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    if (tok->type != JSON_ARRAY || tok->size != 4) {
+        json_set_index(json, index);
+        data->type->funcs.set_frame(data->object, json_next_grect(json));
+        return;
+    }
+    struct Length lengths[4];
+    for (int i = 0; i < 4; i++) {
+        tok = json_next(json);
+        lengths[i] = prv_parse_length(json_token_text(json, tok), tok->len);
+    }
+    if (data->box || prv_is_relative(lengths)) {
+        prv_set_lengths(prv_ensure_box(this, data), lengths);
+    } else {
+        GRect frame = GRect(lengths[0].value, lengths[1].value, lengths[2].value, lengths[3].value);
+        data->type->funcs.set_frame(data->object, frame);
+    }
+}
+
+static void prv_read_anchor(Layout *this, struct LayerData *data, Json *json) {
+    logf();
+    const char *anchor = json_next_string_view(json);
+    if (!anchor) return;
+    struct Box *box = prv_ensure_box(this, data);
+    box->anchor_x = strstr(anchor, "left") ? 0 : strstr(anchor, "right") ? 2 : 1;
+    box->anchor_y = strstr(anchor, "top") ? 0 : strstr(anchor, "bottom") ? 2 : 1;
+}
+
+bool layout_read_box_member(Layout *this, struct LayerData *data, Json *json, JsonToken *key) {
+    logf();
+    if (json_eq(json, key, "frame")) {
+        prv_read_frame(this, data, json);
+    } else if (json_eq(json, key, "anchor")) {
+        prv_read_anchor(this, data, json);
+    } else if (json_eq(json, key, "stack")) {
+        const char *stack = json_next_string_view(json);
+        if (!stack) return true;
+        prv_ensure_box(this, data)->stack = strcmp(stack, "horizontal") == 0 ? BoxStackHorizontal : BoxStackVertical;
+    } else if (json_eq(json, key, "spacing")) {
+        int spacing = json_next_int(json);
+        if (data->box) data->box->spacing = spacing;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void layout_attach_box(Layout *this, struct LayerData *data, struct LayerData *parent) {
+    logf();
+    bool in_stack = parent && parent->box && parent->box->stack != BoxStackNone;
+    if (!data->box && !in_stack) return;
+    struct Box *box = prv_ensure_box(this, data);
+    if (!parent) {
+        prv_place(this, box, prv_resolve_frame(box, prv_parent_size(box)));
+        return;
+    }
+    struct Box *parent_box = prv_ensure_box(this, parent);
+    box->parent = parent_box;
+    if (parent_box->last) {
+        parent_box->last->next = box;
+    } else {
+        parent_box->first = box;
+    }
+    parent_box->last = box;
+}
+
+static void prv_unlink(struct Box *box) {
+    logf();
+    struct Box *prev = NULL;
+    for (struct Box *child = box->parent->first; child; prev = child, child = child->next) {
+        if (child != box) continue;
+        if (prev) {
+            prev->next = box->next;
+        } else {
+            box->parent->first = box->next;
+        }
+        if (box->parent->last == box) box->parent->last = prev;
+        return;
+    }
+}
+
+void layout_attach_placeholder(Layout *this, struct LayerData *data, struct LayerData *parent) {
+    logf();
+    if (!parent || !parent->box || parent->box->stack == BoxStackNone) return;
+    layout_attach_box(this, data, parent);
+    data->box->placeholder = true;
+}
+
+// layout_attach_box() has linked the layer last among its siblings, and the parent has long
+// been laid out, so the layer is moved into the placeholder's slot and its siblings arranged again.
+void layout_place_lazy(Layout *this, struct LayerData *data, struct LayerData *placeholder) {
+    logf();
+    struct Box *box = data->box;
+    if (!box || !box->parent) return;
+    struct Box *parent = box->parent;
+    struct Box *slot = placeholder->box;
+    if (slot && slot->parent == parent && slot->next != box) {
+        prv_unlink(box);
+        box->next = slot->next;
+        slot->next = box;
+        if (parent->last == slot) parent->last = box;
+    }
+    // A parent that only got a box now has not been placed by it.
+    if (parent->frame.size.w < 0) parent->frame = layer_get_frame(prv_get_layer(parent->data));
+    prv_arrange(this, parent);
+}
+
+void layout_detach_box(Layout *this, struct LayerData *data) {
+    logf();
+    if (data->box && data->box->parent) prv_unlink(data->box);
+    layout_drop_box(this, data);
+}
+
+// Keeps the frame as written and forgets the rest, which layout_update_string() reads and
+// links again from the new document.
+void layout_reset_box(Layout *this, struct LayerData *data) {
+    logf();
+    struct Box *box = data->box;
+    if (!box) return;
+    if (box->placeholder) {
+        layout_drop_box(this, data);
+        return;
+    }
+    box->anchor_x = 0;
+    box->anchor_y = 0;
+    box->stack = BoxStackNone;
+    box->spacing = 0;
+    box->parent = NULL;
+    box->first = NULL;
+    box->last = NULL;
+    box->next = NULL;
+    box->frame.size.w = -1;
+}
+
+void layout_drop_box(Layout *this, struct LayerData *data) {
+    logf();
+    struct Box *box = data->box;
+    data->box = NULL;
+    if (!box) return;
+    box->next = this->free_boxes;
+    this->free_boxes = box;
+}
+
+void layout_set_frame(Layout *this, char *id, const char *frame) {
+    logf();
+    struct LayerData *data = dict_get(this->ids, id);
+    if (!data) return;
+
+    struct Length lengths[4] = { { 0, 0 } };
+    const char *s = frame;
+    for (int i = 0; i < 4 && *s; i++) {
+        while (*s == '[' || *s == ' ') s++;
+        const char *end = s;
+        while (*end && *end != ',' && *end != ']') end++;
+        lengths[i] = prv_parse_length(s, end - s);
+        s = *end ? end + 1 : end;
+    }
+
+    struct Box *box = data->box;
+    if (!box) {
+        if (prv_is_relative(lengths)) logw("%s has an absolute frame, ignoring percentages", id);
+        GRect rect = GRect(lengths[0].value, lengths[1].value, lengths[2].value, lengths[3].value);
+        data->type->funcs.set_frame(data->object, rect);
+        return;
+    }
+    prv_set_lengths(box, lengths);
+    // Only the layer, its siblings in a stack and whatever changed size below them move.
+    if (box->parent && box->parent->stack != BoxStackNone) {
+        prv_arrange(this, box->parent);
+    } else {
+        prv_place(this, box, prv_resolve_frame(box, prv_parent_size(box)));
+    }
+}
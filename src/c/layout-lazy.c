@@ -0,0 +1,175 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+#include "stack.h"
+#include "dict.h"
+#include "json.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+// An object marked "lazy" is kept as a copy of its JSON text and tokens, with a hidden,
+// empty layer holding its place among its siblings until it is first shown.
+struct Lazy {
+    Json *json;
+    struct LayerData *placeholder;
+    struct LayerData *data;
+    struct Lazy *parent;
+    // The layer the placeholder was added to, which the real one is laid out in.
+    struct LayerData *container;
+    // Links records that can be used again, without touching parent.
+    struct Lazy *next_free;
+};
+
+struct Dematerialize {
+    Layout *layout;
+    struct Lazy *lazy;
+};
+
+Layer *layout_add_lazy(Layout *this, char *id, Json *json) {
+    logf();
+    struct LayoutType *type = layout_get_type(this, NULL);
+    struct Lazy *lazy = this->free_lazy;
+    if (lazy) {
+        this->free_lazy = lazy->next_free;
+    } else {
+        lazy = arena_alloc(this->arena, sizeof(struct Lazy));
+    }
+    lazy->json = json_copy_tree(json);
+    lazy->placeholder = layout_create_object(this, type, NULL, NULL);
+    lazy->data = NULL;
+    lazy->parent = this->materializing;
+    lazy->container = this->parent;
+    // Not in the ids, but lets dematerializing find the lazy subtree this holds the place of.
+    lazy->placeholder->id = id;
+    dict_put(this->lazy, id, lazy);
+
+    layout_attach_placeholder(this, lazy->placeholder, this->parent);
+
+    Layer *layer = type->funcs.get_layer(lazy->placeholder->object);
+    layer_set_hidden(layer, true);
+    return layer;
+}
+
+static void prv_materialize(Layout *this, char *id, struct Lazy *lazy) {
+    logf();
+    Layer *placeholder = lazy->placeholder->type->funcs.get_layer(lazy->placeholder->object);
+    if (placeholder == this->root) {
+        loge("the root layer cannot be lazy");
+        return;
+    }
+
+    // The copied text lives as long as the record, so strings can point into it.
+    struct Lazy *materializing = this->materializing;
+    struct LayerData *parent = this->parent;
+    bool zero_copy = this->zero_copy;
+    this->materializing = lazy;
+    this->parent = lazy->container;
+    this->zero_copy = true;
+    json_set_index(lazy->json, 0);
+    Layer *layer = layout_create_layer(this, lazy->json, false);
+    this->materializing = materializing;
+    this->parent = parent;
+    this->zero_copy = zero_copy;
+
+    if (!layer) return;
+    layer_insert_above_sibling(layer, placeholder);
+    lazy->data = dict_get(this->ids, id);
+    if (lazy->data) layout_place_lazy(this, lazy->data, lazy->placeholder);
+}
+
+static bool prv_owned(struct LayerData *data, struct Lazy *lazy) {
+    logf();
+    for (struct Lazy *owner = data->owner; owner; owner = owner->parent) {
+        if (owner == lazy) return true;
+    }
+    return false;
+}
+
+// Drops the id of a layer that is about to be destroyed, or the lazy subtree it held the place of.
+static void prv_forget_id(Layout *this, struct LayerData *data) {
+    logf();
+    if (dict_get(this->ids, data->id) == data) dict_remove(this->ids, data->id);
+    struct Lazy *lazy = dict_get(this->lazy, data->id);
+    if (lazy && lazy->placeholder == data) {
+        dict_remove(this->lazy, data->id);
+        json_destroy(lazy->json);
+        // The layers it owns are still found through its parent as the rest of the subtree goes.
+        lazy->next_free = this->free_lazy;
+        this->free_lazy = lazy;
+    }
+}
+
+static bool prv_destroy_owned(struct LayerData *data, void *context) {
+    logf();
+    struct Dematerialize *dematerialize = (struct Dematerialize *) context;
+    Layout *this = dematerialize->layout;
+    if (!prv_owned(data, dematerialize->lazy)) return true;
+    if (data->bound) layout_unbind(this, data, -1);
+    if (data->box) layout_detach_box(this, data);
+    if (data->id) prv_forget_id(this, data);
+    layout_destroy_object(this, data);
+    layout_recycle_data(this, data);
+    return true;
+}
+
+// Destroys every layer created for the subtree, including lazy subtrees inside it, and
+// recycles their records so showing and hiding repeatedly does not grow the arena.
+static void prv_dematerialize(Layout *this, struct Lazy *lazy) {
+    logf();
+    struct Dematerialize dematerialize = {
+        .layout = this,
+        .lazy = lazy
+    };
+    layout_registry_foreach(this, true, prv_destroy_owned, &dematerialize);
+    lazy->data = NULL;
+}
+
+static bool prv_destroy_lazy(char *key, void *value, void *context) {
+    logf();
+    struct Lazy *lazy = (struct Lazy *) value;
+    Layout *this = (Layout *) context;
+    // Layers kept by an update may still point into the text.
+    if (this) {
+        this->buffer_bytes += json_get_text_size(lazy->json);
+        stack_push(this->buffers, json_detach_buffer(lazy->json));
+        lazy->next_free = this->free_lazy;
+        this->free_lazy = lazy;
+    }
+    json_destroy(lazy->json);
+    return true;
+}
+
+void layout_lazy_reset(Layout *this) {
+    logf();
+    dict_foreach(this->lazy, prv_destroy_lazy, this);
+    dict_destroy(this->lazy);
+    this->lazy = dict_create();
+}
+
+void layout_lazy_destroy(Layout *this) {
+    logf();
+    dict_foreach(this->lazy, prv_destroy_lazy, NULL);
+    dict_destroy(this->lazy);
+    this->lazy = NULL;
+}
+
+void layout_show(Layout *this, char *id) {
+    logf();
+    struct Lazy *lazy = dict_get(this->lazy, id);
+    if (lazy && !lazy->data) prv_materialize(this, id, lazy);
+    struct LayerData *data = lazy ? lazy->data : dict_get(this->ids, id);
+    if (data) layer_set_hidden(data->type->funcs.get_layer(data->object), false);
+}
+
+void layout_hide(Layout *this, char *id, bool destroy) {
+    logf();
+    struct Lazy *lazy = dict_get(this->lazy, id);
+    struct LayerData *data = lazy ? lazy->data : dict_get(this->ids, id);
+    if (!data) return;
+    if (lazy && destroy) {
+        prv_dematerialize(this, lazy);
+    } else {
+        layer_set_hidden(data->type->funcs.get_layer(data->object), true);
+    }
+}
@@ -0,0 +1,150 @@
+#pragma once
+#include <pebble.h>
+#include "arena.h"
+#include "stack.h"
+#include "dict.h"
+#include "layout-profile.h"
+#include "pebble-layout.h"
+
+struct Layout {
+    Arena *arena;
+    Layer *root;
+    // Layer records in creation order, see layout-registry.c.
+    struct LayerBlock *first_block;
+    struct LayerBlock *last_block;
+    uint16_t num_handles;
+    Dict *ids;
+    Dict *types;
+    Dict *fonts;
+    Dict *resource_ids;
+    Stack *buffers;
+    Dict *bindings;
+    AppTimer *flush_timer;
+    Dict *lazy;
+    struct Lazy *materializing;
+    // Records that showing and hiding lazy layers, or updating, would otherwise take from the
+    // arena again each time.
+    Stack *free_data;
+    // Linked through their own next pointers.
+    struct Box *free_boxes;
+    struct BindingTarget *free_targets;
+    struct Lazy *free_lazy;
+    // Strings that belong to single layers, see layout_own_string().
+    struct OwnedString *strings;
+    // The layer whose "layers" are being created.
+    struct LayerData *parent;
+    // Heap accounting for layout_get_stats(), see layout-stats.c.
+    size_t buffer_bytes;
+    size_t string_bytes;
+    size_t parse_json_bytes;
+    size_t parse_start;
+    size_t parse_peak;
+    bool parsing;
+    bool updating;
+#ifdef LAYOUT_PROFILE
+    LayoutProfile profile;
+#endif
+    uint16_t generation;
+    bool zero_copy;
+    bool system_fonts;
+};
+
+struct PropertyHash {
+    uint32_t name;
+    uint32_t *values;
+};
+
+struct LayoutType {
+    LayoutFuncs funcs;
+    uint8_t num_properties;
+    struct PropertyHash *hashes;
+    uint16_t num_objects;
+    size_t object_bytes;
+    // Hash arrays of recycled layers, all of this type's size, linked through their first bytes.
+    void *free_hashes;
+#ifdef LAYOUT_PROFILE
+    uint16_t num_created;
+    uint32_t create_ms;
+#endif
+};
+
+struct LayerData {
+    struct LayoutType *type;
+    // NULL once the layer has been destroyed.
+    void *object;
+    // The id this layer was registered under, if any.
+    char *id;
+    // Set by layout_update_string(): hashes of the frame and each property's JSON text, so
+    // unchanged values are not applied again, and below, the generation that last saw this layer.
+    uint32_t *hashes;
+    // The lazy subtree this layer was created for, see layout-lazy.c.
+    struct Lazy *owner;
+    // Set for layers positioned relative to their parent, see layout-frames.c.
+    struct Box *box;
+    // Counts how often the record has been recycled, so old handles to it stop resolving.
+    uint16_t reuses;
+    uint16_t generation;
+    // Heap the object took when it was created.
+    uint16_t bytes;
+    // Whether any property is bound to a value, see layout-bindings.c.
+    bool bound : 1;
+    // Whether layout_own_string() keeps strings for this layer.
+    bool owns_strings : 1;
+    // Which of the first LAYOUT_APPLIED_SLOTS slots (the frame, then each property) were set,
+    // so layout_update_string() can tell what a new document leaves out. All set when unknown.
+    uint8_t applied;
+};
+
+#define LAYOUT_APPLIED_SLOTS 8
+#define LAYOUT_APPLIED_UNKNOWN 0xFF
+
+typedef bool (*LayerDataCallback)(struct LayerData *data, void *context);
+
+struct LayoutType *layout_get_type(Layout *this, char *name);
+int layout_type_find_property(struct LayoutType *type, uint32_t hash, const char *name, size_t len);
+int layout_type_enum_value(struct LayoutType *type, int property, uint32_t hash, const char *name, size_t len);
+struct LayerData *layout_add_object(Layout *this, struct LayoutType *type, void *object);
+void layout_recycle_data(Layout *this, struct LayerData *data);
+void layout_note_applied(struct LayerData *data, int slot);
+bool layout_was_applied(struct LayerData *data, int slot);
+void layout_set_root(Layout *this, Layer *root);
+Layer *layout_create_layer(Layout *this, Json *json, bool allow_lazy);
+char *layout_copy_string(Layout *this, const char *s, size_t len);
+char *layout_keep_string(Layout *this, const char *s);
+// Copies s into a heap buffer that belongs to the layer's slot, reusing the one it had.
+char *layout_own_string(Layout *this, struct LayerData *data, int slot, const char *s);
+void layout_release_strings(Layout *this, struct LayerData *data);
+void layout_owned_strings_destroy(Layout *this);
+void layout_keep_buffer(Layout *this, void *buffer, size_t size);
+void layout_release_buffers(Layout *this);
+void layout_set_id(Layout *this, char *id, struct LayerData *data);
+void layout_apply_property(Layout *this, struct LayerData *data, int index, Json *json);
+bool layout_decode_value(Layout *this, struct LayoutType *type, int property, const char *text, LayoutValue *value);
+bool layout_is_placeholder(const char *text, size_t len);
+bool layout_bind(Layout *this, struct LayerData *data, int property, Json *json);
+// A negative property unbinds all of the layer's properties.
+void layout_unbind(Layout *this, struct LayerData *data, int property);
+void layout_bindings_destroy(Layout *this);
+Layer *layout_add_lazy(Layout *this, char *id, Json *json);
+void layout_lazy_reset(Layout *this);
+void layout_lazy_destroy(Layout *this);
+bool layout_read_box_member(Layout *this, struct LayerData *data, Json *json, JsonToken *key);
+void layout_attach_box(Layout *this, struct LayerData *data, struct LayerData *parent);
+void layout_attach_placeholder(Layout *this, struct LayerData *data, struct LayerData *parent);
+void layout_place_lazy(Layout *this, struct LayerData *data, struct LayerData *placeholder);
+void layout_detach_box(Layout *this, struct LayerData *data);
+void layout_reset_box(Layout *this, struct LayerData *data);
+// Only when every box is dropped at once, as their parents are not updated.
+void layout_drop_box(Layout *this, struct LayerData *data);
+struct LayerData *layout_create_object(Layout *this, struct LayoutType *type, Json *json, JsonToken *token);
+void layout_destroy_object(Layout *this, struct LayerData *data);
+void layout_stats_begin_parse(Layout *this);
+void layout_stats_sample(Layout *this);
+void layout_stats_end_parse(Layout *this, Json *json);
+void layout_profile_reset(Layout *this);
+size_t layout_font_size(Layout *this, uint16_t *count);
+void layout_reserve_layers(Layout *this, uint16_t count);
+struct LayerData *layout_registry_add(Layout *this);
+struct LayerData *layout_registry_get(Layout *this, LayoutHandle handle);
+void layout_registry_foreach(Layout *this, bool newest_first, LayerDataCallback callback, void *context);
+void layout_registry_destroy(Layout *this);
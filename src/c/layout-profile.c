@@ -0,0 +1,82 @@
+#include <pebble.h>
+#include "logging.h"
+#include "dict.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+#ifdef LAYOUT_PROFILE
+struct TypeProfile {
+    LayoutTypeProfileCallback callback;
+    void *context;
+};
+
+uint32_t layout_profile_now(void) {
+    logf();
+    time_t seconds;
+    uint16_t ms = time_ms(&seconds, NULL);
+    return (uint32_t) seconds * 1000 + ms;
+}
+
+static bool prv_reset_type(char *key, void *value, void *context) {
+    logf();
+    struct LayoutType *type = (struct LayoutType *) value;
+    type->num_created = 0;
+    type->create_ms = 0;
+    return true;
+}
+
+static bool prv_type_callback(char *key, void *value, void *context) {
+    logf();
+    struct LayoutType *type = (struct LayoutType *) value;
+    struct TypeProfile *profile = (struct TypeProfile *) context;
+    profile->callback(key, type->num_created, type->create_ms, profile->context);
+    return true;
+}
+
+static void prv_log_type(const char *type, uint16_t num_created, uint32_t create_ms, void *context) {
+    logf();
+    if (num_created) logi("  %s: %d created in %d ms", type, num_created, (int) create_ms);
+}
+#endif
+
+void layout_profile_reset(Layout *this) {
+    logf();
+#ifdef LAYOUT_PROFILE
+    memset(&this->profile, 0, sizeof(LayoutProfile));
+    dict_foreach(this->types, prv_reset_type, NULL);
+#endif
+}
+
+bool layout_get_profile(Layout *this, LayoutProfile *profile) {
+    logf();
+#ifdef LAYOUT_PROFILE
+    *profile = this->profile;
+    return true;
+#else
+    memset(profile, 0, sizeof(LayoutProfile));
+    return false;
+#endif
+}
+
+void layout_foreach_type_profile(Layout *this, LayoutTypeProfileCallback callback, void *context) {
+    logf();
+#ifdef LAYOUT_PROFILE
+    struct TypeProfile profile = {
+        .callback = callback,
+        .context = context
+    };
+    dict_foreach(this->types, prv_type_callback, &profile);
+#endif
+}
+
+void layout_log_profile(Layout *this) {
+    logf();
+#ifdef LAYOUT_PROFILE
+    LayoutProfile *profile = &this->profile;
+    logi("parse: load %d ms, tokenize %d ms (%d tokens), create %d ms, root %d ms", (int) profile->load_ms,
+        (int) profile->tokenize_ms, profile->num_tokens, (int) profile->create_ms, (int) profile->root_ms);
+    layout_foreach_type_profile(this, prv_log_type, NULL);
+#else
+    logw("layout profiling is not compiled in, define LAYOUT_PROFILE");
+#endif
+}
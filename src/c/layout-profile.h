@@ -0,0 +1,17 @@
+#pragma once
+
+//#define LAYOUT_PROFILE
+
+// Timing of the phases of a parse, read with layout_get_profile(). Without LAYOUT_PROFILE the
+// macros expand to nothing, so they can stay in release builds.
+#ifdef LAYOUT_PROFILE
+#define profile_start(name) uint32_t profile_##name = layout_profile_now();
+#define profile_add(total, name) (total) += layout_profile_now() - profile_##name;
+#define profile_reset(layout) layout_profile_reset(layout);
+
+uint32_t layout_profile_now(void);
+#else
+#define profile_start(name)
+#define profile_add(total, name)
+#define profile_reset(layout)
+#endif
@@ -0,0 +1,149 @@
+#include <pebble.h>
+#include "logging.h"
+#include "arena.h"
+#include "stack.h"
+#include "dict.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+#ifndef LAYOUT_LAYER_BLOCK
+#define LAYOUT_LAYER_BLOCK 8
+#endif
+
+// Layer records are kept in creation order in arena blocks, one sized for the whole document
+// when parsing starts and small ones after that, so a record never moves and its position goes
+// into its handle. Destroyed layers leave a record with no object behind, which iteration skips
+// and later layers may take.
+struct LayerBlock {
+    struct LayerBlock *prev;
+    struct LayerBlock *next;
+    LayoutHandle first;
+    uint16_t capacity;
+    uint16_t count;
+    struct LayerData data[];
+};
+
+static struct LayerBlock *prv_add_block(Layout *this, uint16_t capacity) {
+    logf();
+    struct LayerBlock *block = arena_alloc(this->arena, sizeof(struct LayerBlock) + sizeof(struct LayerData) * capacity);
+    block->prev = this->last_block;
+    block->next = NULL;
+    block->first = this->num_handles;
+    block->capacity = capacity;
+    block->count = 0;
+    if (this->last_block) {
+        this->last_block->next = block;
+    } else {
+        this->first_block = block;
+    }
+    this->last_block = block;
+    return block;
+}
+
+void layout_reserve_layers(Layout *this, uint16_t count) {
+    logf();
+    struct LayerBlock *block = this->last_block;
+    if (block && block->capacity - block->count >= count) return;
+    // The unused end of a smaller block is given up; handles stay contiguous.
+    if (block) block->capacity = block->count;
+    prv_add_block(this, count > LAYOUT_LAYER_BLOCK ? count : LAYOUT_LAYER_BLOCK);
+}
+
+struct LayerData *layout_registry_add(Layout *this) {
+    logf();
+    struct LayerBlock *block = this->last_block;
+    if (!block || block->count == block->capacity) block = prv_add_block(this, LAYOUT_LAYER_BLOCK);
+    struct LayerData *data = &block->data[block->count++];
+    data->reuses = 0;
+    this->num_handles++;
+    return data;
+}
+
+static LayoutHandle prv_handle(Layout *this, struct LayerData *data) {
+    logf();
+    for (struct LayerBlock *block = this->last_block; block; block = block->prev) {
+        if (data >= block->data && data < block->data + block->count) {
+            return (LayoutHandle) data->reuses << 16 | (block->first + (data - block->data));
+        }
+    }
+    return LAYOUT_HANDLE_NONE;
+}
+
+struct LayerData *layout_registry_get(Layout *this, LayoutHandle handle) {
+    logf();
+    uint16_t position = handle & 0xFFFF;
+    if (handle == LAYOUT_HANDLE_NONE || position >= this->num_handles) return NULL;
+    // Most layouts have one block, or one big block followed by a few small ones.
+    for (struct LayerBlock *block = this->last_block; block; block = block->prev) {
+        if (position < block->first) continue;
+        struct LayerData *data = &block->data[position - block->first];
+        // A handle from before the record was recycled belongs to a layer that is gone.
+        return data->reuses == handle >> 16 ? data : NULL;
+    }
+    return NULL;
+}
+
+void layout_registry_foreach(Layout *this, bool newest_first, LayerDataCallback callback, void *context) {
+    logf();
+    if (newest_first) {
+        for (struct LayerBlock *block = this->last_block; block; block = block->prev) {
+            for (int i = block->count - 1; i >= 0; i--) {
+                if (block->data[i].object && !callback(&block->data[i], context)) return;
+            }
+        }
+    } else {
+        for (struct LayerBlock *block = this->first_block; block; block = block->next) {
+            for (int i = 0; i < block->count; i++) {
+                if (block->data[i].object && !callback(&block->data[i], context)) return;
+            }
+        }
+    }
+}
+
+void layout_registry_destroy(Layout *this) {
+    logf();
+    // Blocks belong to the arena.
+    this->first_block = NULL;
+    this->last_block = NULL;
+    this->num_handles = 0;
+}
+
+LayoutHandle layout_get_handle(Layout *this, char *id) {
+    logf();
+    struct LayerData *data = dict_get(this->ids, id);
+    return data ? prv_handle(this, data) : LAYOUT_HANDLE_NONE;
+}
+
+void *layout_get_object(Layout *this, LayoutHandle handle) {
+    logf();
+    struct LayerData *data = layout_registry_get(this, handle);
+    return data ? data->object : NULL;
+}
+
+Layer *layout_get_layer(Layout *this, LayoutHandle handle) {
+    logf();
+    struct LayerData *data = layout_registry_get(this, handle);
+    return data && data->object ? data->type->funcs.get_layer(data->object) : NULL;
+}
+
+struct Foreach {
+    Layout *layout;
+    LayoutForeachCallback callback;
+    void *context;
+};
+
+static bool prv_foreach_callback(struct LayerData *data, void *context) {
+    logf();
+    struct Foreach *foreach = (struct Foreach *) context;
+    return foreach->callback(prv_handle(foreach->layout, data), data->object, data->type->funcs.get_layer(data->object), foreach->context);
+}
+
+void layout_foreach(Layout *this, LayoutForeachCallback callback, void *context) {
+    logf();
+    struct Foreach foreach = {
+        .layout = this,
+        .callback = callback,
+        .context = context
+    };
+    layout_registry_foreach(this, false, prv_foreach_callback, &foreach);
+}
@@ -0,0 +1,108 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+#include "stack.h"
+#include "dict.h"
+#include "json.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+// Pebble's allocator cannot report the size of a block, so objects and fonts are
+// measured with heap_bytes_used() around the call that creates them, and everything the
+// layout allocates itself is sized from its own bookkeeping.
+
+struct TypeStats {
+    LayoutTypeStatsCallback callback;
+    void *context;
+};
+
+struct LayerData *layout_create_object(Layout *this, struct LayoutType *type, Json *json, JsonToken *token) {
+    logf();
+    profile_start(create);
+    size_t before = heap_bytes_used();
+    void *object = type->funcs.create(this, json, token);
+    size_t after = heap_bytes_used();
+    profile_add(type->create_ms, create);
+#ifdef LAYOUT_PROFILE
+    type->num_created++;
+#endif
+    struct LayerData *data = layout_add_object(this, type, object);
+    data->bytes = after > before ? after - before : 0;
+    type->num_objects++;
+    type->object_bytes += data->bytes;
+    layout_stats_sample(this);
+    return data;
+}
+
+void layout_destroy_object(Layout *this, struct LayerData *data) {
+    logf();
+    struct LayoutType *type = data->type;
+    type->num_objects--;
+    type->object_bytes -= data->bytes;
+    type->funcs.destroy(data->object);
+    layout_release_strings(this, data);
+}
+
+void layout_stats_begin_parse(Layout *this) {
+    logf();
+    this->parsing = true;
+    this->parse_start = heap_bytes_used();
+    this->parse_peak = 0;
+    this->parse_json_bytes = 0;
+}
+
+void layout_stats_sample(Layout *this) {
+    logf();
+    if (!this->parsing) return;
+    size_t used = heap_bytes_used();
+    if (used > this->parse_start && used - this->parse_start > this->parse_peak) {
+        this->parse_peak = used - this->parse_start;
+    }
+}
+
+void layout_stats_end_parse(Layout *this, Json *json) {
+    logf();
+    if (json) this->parse_json_bytes = json_get_heap_size(json);
+    layout_stats_sample(this);
+    this->parsing = false;
+}
+
+static bool prv_type_callback(char *key, void *value, void *context) {
+    logf();
+    struct LayoutType *type = (struct LayoutType *) value;
+    struct TypeStats *stats = (struct TypeStats *) context;
+    stats->callback(key, type->num_objects, type->object_bytes, stats->context);
+    return true;
+}
+
+static bool prv_sum_objects(char *key, void *value, void *context) {
+    logf();
+    struct LayoutType *type = (struct LayoutType *) value;
+    LayoutStats *stats = (LayoutStats *) context;
+    stats->num_layers += type->num_objects;
+    stats->layer_bytes += type->object_bytes;
+    return true;
+}
+
+void layout_foreach_type_stats(Layout *this, LayoutTypeStatsCallback callback, void *context) {
+    logf();
+    struct TypeStats stats = {
+        .callback = callback,
+        .context = context
+    };
+    dict_foreach(this->types, prv_type_callback, &stats);
+}
+
+void layout_get_stats(Layout *this, LayoutStats *stats) {
+    logf();
+    memset(stats, 0, sizeof(LayoutStats));
+    stats->parse_json_bytes = this->parse_json_bytes;
+    stats->parse_peak_bytes = this->parse_peak;
+    stats->arena_bytes = arena_get_size(this->arena);
+    stats->dict_bytes = dict_get_size(this->ids) + dict_get_size(this->types) + dict_get_size(this->fonts) +
+        dict_get_size(this->resource_ids) + dict_get_size(this->bindings) + dict_get_size(this->lazy);
+    stats->buffer_bytes = this->buffer_bytes + this->string_bytes;
+    dict_foreach(this->types, prv_sum_objects, stats);
+    stats->font_bytes = layout_font_size(this, &stats->num_fonts);
+}
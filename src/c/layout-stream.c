@@ -0,0 +1,308 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "json-stream.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+#ifndef LAYOUT_STREAM_WINDOW
+#define LAYOUT_STREAM_WINDOW 256
+#endif
+
+#define LAYOUT_STREAM_MAX_KEY 32
+
+// Members of an object that arrive before it can be created are buffered as records of
+// a tag byte, the NUL-terminated key and a payload: NUL-terminated text for strings and
+// primitives, four int16 values for rects.
+typedef enum {
+    PendingString = 'S',
+    PendingPrimitive = 'P',
+    PendingRect = 'R'
+} PendingTag;
+
+struct Stream {
+    Layout *layout;
+    JsonStream *json;
+    bool error;
+};
+
+struct StreamObject {
+    struct LayoutType *type;
+    struct LayerData *data;
+    void *object;
+    char *pending;
+    uint16_t pending_len;
+};
+
+static bool prv_key_eq(const char *key, const char *s) {
+    logf();
+    return strcmp(key, s) == 0;
+}
+
+static void prv_pend(struct StreamObject *this, PendingTag tag, const char *key, const void *payload, size_t len) {
+    logf();
+    size_t key_len = strlen(key) + 1;
+    char *pending = realloc(this->pending, this->pending_len + 1 + key_len + len);
+    if (!pending) return;
+    this->pending = pending;
+    pending += this->pending_len;
+    pending[0] = tag;
+    memcpy(pending + 1, key, key_len);
+    memcpy(pending + 1 + key_len, payload, len);
+    this->pending_len += 1 + key_len + len;
+}
+
+static bool prv_decode(Layout *layout, struct LayoutType *type, int index, PendingTag tag, const char *text,
+        const int16_t *rect, LayoutValue *value) {
+    logf();
+    const LayoutProperty *property = &type->funcs.properties[index];
+    if (property->kind == LayoutPropertyRect) {
+        if (tag != PendingRect) return false;
+        value->rect = GRect(rect[0], rect[1], rect[2], rect[3]);
+        return true;
+    }
+    if (tag == PendingRect || property->kind == LayoutPropertyLayers) return false;
+    if (property->kind == LayoutPropertyBool && tag != PendingPrimitive) return false;
+    // Strings are always copied, since the text lives in a window or pending buffer that is
+    // about to be reused.
+    return layout_decode_value(layout, type, index, text, value);
+}
+
+static void prv_apply(struct Stream *this, struct StreamObject *object, PendingTag tag, const char *key,
+        const char *text, const int16_t *rect) {
+    logf();
+    Layout *layout = this->layout;
+    struct LayoutType *type = object->type;
+    if (tag != PendingRect && prv_key_eq(key, "id")) {
+        layout_set_id(layout, layout_copy_string(layout, text, strlen(text)), object->data);
+        return;
+    }
+    if (tag == PendingRect && prv_key_eq(key, "frame")) {
+        type->funcs.set_frame(object->object, GRect(rect[0], rect[1], rect[2], rect[3]));
+        return;
+    }
+
+    size_t len = strlen(key);
+    int index = layout_type_find_property(type, dict_hash(key, len), key, len);
+    LayoutValue value;
+    if (index >= 0 && prv_decode(layout, type, index, tag, text, rect, &value)) {
+        type->funcs.properties[index].set(layout, object->object, value);
+    }
+}
+
+static void prv_create(struct Stream *this, struct StreamObject *object) {
+    logf();
+    if (object->object) return;
+    if (!object->type) object->type = layout_get_type(this->layout, NULL);
+    object->data = layout_create_object(this->layout, object->type, NULL, NULL);
+    object->object = object->data->object;
+
+    const char *p = object->pending;
+    const char *end = p + object->pending_len;
+    while (p < end) {
+        PendingTag tag = (PendingTag) *p++;
+        const char *key = p;
+        p += strlen(key) + 1;
+        if (tag == PendingRect) {
+            int16_t rect[4];
+            memcpy(rect, p, sizeof(rect));
+            p += sizeof(rect);
+            prv_apply(this, object, tag, key, NULL, rect);
+        } else {
+            prv_apply(this, object, tag, key, p, NULL);
+            p += strlen(p) + 1;
+        }
+    }
+    free(object->pending);
+    object->pending = NULL;
+    object->pending_len = 0;
+}
+
+static void prv_set_type(struct Stream *this, struct StreamObject *object, const char *name) {
+    logf();
+    if (object->object) {
+        logw("\"type\" after \"layers\" is ignored when streaming");
+        return;
+    }
+    struct LayoutType *type = layout_get_type(this->layout, (char *) name);
+    if (!type->funcs.properties) {
+        logw("%s has no property schema, using Layer", name);
+        type = layout_get_type(this->layout, NULL);
+    }
+    object->type = type;
+}
+
+// Reads up to four numbers; anything else in the array makes it an unusable rect.
+static bool prv_read_rect(struct Stream *this, int16_t *rect) {
+    logf();
+    int n = 0;
+    bool valid = true;
+    for (;;) {
+        JsonEvent event = json_stream_next(this->json);
+        if (event == JsonEventArrayEnd) return valid && n == 4;
+        if (event == JsonEventError || event == JsonEventEnd) {
+            this->error = true;
+            return false;
+        }
+        if (event == JsonEventPrimitive && n < 4) {
+            rect[n++] = json_parse_int(json_stream_text(this->json), json_stream_len(this->json));
+        } else {
+            valid = false;
+            json_stream_skip(this->json, event);
+        }
+    }
+}
+
+static Layer *prv_read_object(struct Stream *this);
+
+static void prv_read_layers(struct Stream *this, struct StreamObject *object, int index) {
+    logf();
+    const LayoutProperty *property = &object->type->funcs.properties[index];
+    for (;;) {
+        JsonEvent event = json_stream_next(this->json);
+        if (event == JsonEventArrayEnd) return;
+        if (event == JsonEventError || event == JsonEventEnd) {
+            this->error = true;
+            return;
+        }
+        if (event != JsonEventObjectStart) {
+            json_stream_skip(this->json, event);
+            continue;
+        }
+        LayoutValue value = { .layer = prv_read_object(this) };
+        if (this->error) return;
+        if (value.layer) property->set(this->layout, object->object, value);
+    }
+}
+
+static void prv_skip_value(struct Stream *this) {
+    logf();
+    JsonEvent event = json_stream_next(this->json);
+    if (event != JsonEventString && event != JsonEventPrimitive && event != JsonEventObjectStart &&
+            event != JsonEventArrayStart) {
+        this->error = true;
+        return;
+    }
+    json_stream_skip(this->json, event);
+}
+
+// What a member asks for that only the token based parsers can do, or NULL.
+static const char *prv_unsupported(const char *key) {
+    logf();
+    if (strchr(key, '@') || prv_key_eq(key, "if")) return "conditions";
+    if (prv_key_eq(key, "lazy")) return "lazy layers";
+    if (prv_key_eq(key, "anchor") || prv_key_eq(key, "stack") || prv_key_eq(key, "spacing")) {
+        return "anchors, stacks or spacing";
+    }
+    return NULL;
+}
+
+static void prv_read_member(struct Stream *this, struct StreamObject *object, const char *key) {
+    logf();
+    const char *unsupported = prv_unsupported(key);
+    if (unsupported) {
+        loge("streamed layouts do not support %s, ignoring %s", unsupported, key);
+        prv_skip_value(this);
+        return;
+    }
+
+    JsonEvent event = json_stream_next(this->json);
+    const char *text = json_stream_text(this->json);
+
+    switch (event) {
+        case JsonEventString:
+        case JsonEventPrimitive: {
+            PendingTag tag = event == JsonEventString ? PendingString : PendingPrimitive;
+            if (event == JsonEventString && layout_is_placeholder(text, json_stream_len(this->json))) {
+                loge("streamed layouts do not support bindings, setting %s as written", text);
+            }
+            if (event == JsonEventString && prv_key_eq(key, "type")) {
+                prv_set_type(this, object, text);
+            } else if (object->object) {
+                prv_apply(this, object, tag, key, text, NULL);
+            } else {
+                prv_pend(object, tag, key, text, json_stream_len(this->json) + 1);
+            }
+            return;
+        }
+        case JsonEventArrayStart: {
+            struct LayoutType *type = object->type ? object->type : layout_get_type(this->layout, NULL);
+            size_t len = strlen(key);
+            int index = layout_type_find_property(type, dict_hash(key, len), key, len);
+            if (index >= 0 && type->funcs.properties[index].kind == LayoutPropertyLayers) {
+                // Children attach to their parent as they complete, so it has to exist now.
+                prv_create(this, object);
+                prv_read_layers(this, object, index);
+                return;
+            }
+            int16_t rect[4];
+            if (!prv_read_rect(this, rect)) {
+                if (!this->error) loge("streamed layouts only support rects of four numbers, ignoring %s", key);
+                return;
+            }
+            if (object->object) {
+                prv_apply(this, object, PendingRect, key, NULL, rect);
+            } else {
+                prv_pend(object, PendingRect, key, rect, sizeof(rect));
+            }
+            return;
+        }
+        case JsonEventObjectStart:
+            json_stream_skip(this->json, event);
+            return;
+        default:
+            this->error = true;
+            return;
+    }
+}
+
+static Layer *prv_read_object(struct Stream *this) {
+    logf();
+    struct StreamObject object = { NULL };
+    char key[LAYOUT_STREAM_MAX_KEY];
+
+    for (;;) {
+        JsonEvent event = json_stream_next(this->json);
+        if (event == JsonEventObjectEnd) break;
+        if (event != JsonEventKey) {
+            this->error = true;
+            break;
+        }
+        // Keys this long are ignored rather than cut short, which could match a shorter name.
+        uint16_t len = json_stream_len(this->json);
+        if (len >= sizeof(key)) {
+            prv_skip_value(this);
+            if (this->error) break;
+            continue;
+        }
+        memcpy(key, json_stream_text(this->json), len + 1);
+        prv_read_member(this, &object, key);
+        if (this->error) break;
+    }
+
+    if (this->error && !object.object) {
+        free(object.pending);
+        return NULL;
+    }
+    prv_create(this, &object);
+    return object.type->funcs.get_layer(object.object);
+}
+
+void layout_parse_stream(Layout *this, uint32_t resource_id) {
+    logf();
+    layout_stats_begin_parse(this);
+    struct Stream stream = {
+        .layout = this,
+        .json = json_stream_create_with_resource(resource_id, LAYOUT_STREAM_WINDOW)
+    };
+    if (json_stream_next(stream.json) == JsonEventObjectStart) {
+        Layer *root = prv_read_object(&stream);
+        if (!stream.error && json_stream_next(stream.json) != JsonEventEnd) stream.error = true;
+        layout_set_root(this, root);
+    } else {
+        stream.error = true;
+    }
+    if (stream.error) loge("failed to stream json layout");
+    layout_stats_end_parse(this, NULL);
+    json_stream_destroy(stream.json);
+}
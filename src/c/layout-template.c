@@ -0,0 +1,279 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+#include "json.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+// A template is a layer tree with every type looked up and every value decoded, so
+// instantiating it only creates objects and calls setters. It lives in its layout's arena.
+struct TemplateNode;
+
+struct TemplateValue {
+    uint8_t property;
+    LayoutValue value;
+    uint16_t num_children;
+    struct TemplateNode *children;
+};
+
+struct TemplateNode {
+    struct LayoutType *type;
+    const char *id;
+    bool has_frame;
+    GRect frame;
+    uint8_t num_values;
+    struct TemplateValue *values;
+};
+
+struct LayoutTemplate {
+    Layout *layout;
+    struct TemplateNode *root;
+};
+
+struct Instance {
+    Layout *layout;
+    Layer *root;
+};
+
+// Returns the text of the next string or primitive, or skips a container and returns NULL.
+static const char *prv_next_text(Json *json) {
+    logf();
+    int16_t index = json_get_index(json);
+    const char *text = json_next_string_view(json);
+    if (!text) {
+        json_set_index(json, index);
+        json_skip_tree(json);
+    }
+    return text;
+}
+
+// Whether the next value is a frame with a percentage in it.
+static bool prv_is_relative_frame(Json *json) {
+    logf();
+    int16_t index = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    bool relative = false;
+    for (int i = 0; tok->type == JSON_ARRAY && i < tok->size && !relative; i++) {
+        JsonToken *length = json_next(json);
+        relative = length->type == JSON_STRING && memchr(json_token_text(json, length), '%', length->len);
+    }
+    json_set_index(json, index);
+    return relative;
+}
+
+static bool prv_build_node(LayoutTemplate *this, Json *json, struct TemplateNode *node);
+
+static void prv_build_layers(LayoutTemplate *this, Json *json, struct TemplateValue *value) {
+    logf();
+    int16_t index = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    if (tok->type != JSON_ARRAY) {
+        json_set_index(json, index);
+        json_skip_tree(json);
+        return;
+    }
+    int size = tok->size;
+    value->children = arena_alloc(this->layout->arena, sizeof(struct TemplateNode) * size);
+    for (int i = 0; i < size; i++) {
+        if (prv_build_node(this, json, &value->children[value->num_children])) value->num_children++;
+    }
+}
+
+static bool prv_build_node(LayoutTemplate *this, Json *json, struct TemplateNode *node) {
+    logf();
+    Layout *layout = this->layout;
+    int16_t start = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    if (tok->type != JSON_OBJECT) {
+        json_set_index(json, start);
+        json_skip_tree(json);
+        return false;
+    }
+
+    int size = tok->size;
+    int16_t members = json_get_index(json);
+    const char *type_name = NULL;
+    for (int i = 0; i < size; i++) {
+        tok = json_next(json);
+        if (!type_name && json_eq(json, tok, "type")) type_name = prv_next_text(json);
+        else json_skip_tree(json);
+    }
+    struct LayoutType *type = layout_get_type(layout, (char *) type_name);
+    if (!type->funcs.properties) {
+        logw("%s has no property schema, using Layer", type_name);
+        type = layout_get_type(layout, NULL);
+    }
+
+    node->type = type;
+    node->id = NULL;
+    node->has_frame = false;
+    node->num_values = 0;
+    node->values = arena_alloc(layout->arena, sizeof(struct TemplateValue) * size);
+
+    json_set_index(json, members);
+    for (int i = 0; i < size; i++) {
+        tok = json_next(json);
+        int property = -1;
+        if (json_eq(json, tok, "id")) {
+            const char *id = prv_next_text(json);
+            if (id) node->id = layout_copy_string(layout, id, strlen(id));
+        } else if (json_eq(json, tok, "frame")) {
+            // Instances are positioned once, so only plain frames can be honoured.
+            if (prv_is_relative_frame(json)) {
+                loge("template frames cannot be relative, leaving the frame out");
+                json_skip_tree(json);
+            } else {
+                node->frame = json_next_grect(json);
+                node->has_frame = true;
+            }
+        } else if (json_eq(json, tok, "anchor") || json_eq(json, tok, "stack") || json_eq(json, tok, "spacing")) {
+            logw("templates do not support %.*s, ignoring it", tok->len, json_token_text(json, tok));
+            json_skip_tree(json);
+        } else if (tok->type == JSON_STRING &&
+                (property = layout_type_find_property(type, dict_hash(json_token_text(json, tok), tok->len),
+                    json_token_text(json, tok), tok->len)) >= 0) {
+            struct TemplateValue *value = &node->values[node->num_values];
+            value->property = property;
+            value->num_children = 0;
+            value->children = NULL;
+            LayoutPropertyKind kind = type->funcs.properties[property].kind;
+            if (kind == LayoutPropertyLayers) {
+                prv_build_layers(this, json, value);
+                node->num_values++;
+            } else if (kind == LayoutPropertyRect) {
+                value->value.rect = json_next_grect(json);
+                node->num_values++;
+            } else {
+                const char *text = prv_next_text(json);
+                if (text && layout_is_placeholder(text, strlen(text))) {
+                    logw("templates do not support bindings, setting %s as written", text);
+                }
+                if (text && layout_decode_value(layout, type, property, text, &value->value)) node->num_values++;
+            }
+        } else {
+            json_skip_tree(json);
+        }
+    }
+    return true;
+}
+
+static LayoutTemplate *prv_create(Layout *layout, Json *json) {
+    logf();
+    LayoutTemplate *this = arena_alloc(layout->arena, sizeof(LayoutTemplate));
+    this->layout = layout;
+    this->root = arena_alloc(layout->arena, sizeof(struct TemplateNode));
+    if (!json_has_next(json) || !prv_build_node(this, json, this->root)) {
+        loge("invalid layout template");
+        this->root = NULL;
+    }
+    json_destroy(json);
+    return this;
+}
+
+LayoutTemplate *layout_template_create(Layout *layout, char *json) {
+    logf();
+    return prv_create(layout, json_create(json));
+}
+
+LayoutTemplate *layout_template_create_with_resource(Layout *layout, uint32_t resource_id) {
+    logf();
+    return prv_create(layout, json_create_with_resource(resource_id));
+}
+
+static const LayoutOverride *prv_find_override(const char *id, const char *property,
+        const LayoutOverride *overrides, uint8_t num_overrides) {
+    logf();
+    if (!id) return NULL;
+    for (uint8_t i = 0; i < num_overrides; i++) {
+        if (strcmp(overrides[i].id, id) == 0 && strcmp(overrides[i].property, property) == 0) return &overrides[i];
+    }
+    return NULL;
+}
+
+static Layer *prv_instantiate(LayoutTemplate *this, struct TemplateNode *node,
+        const LayoutOverride *overrides, uint8_t num_overrides) {
+    logf();
+    Layout *layout = this->layout;
+    struct LayoutType *type = node->type;
+    struct LayerData *data = layout_create_object(layout, type, NULL, NULL);
+    void *object = data->object;
+
+    // A new id belongs to the layer, so destroying the instance gives it back.
+    const LayoutOverride *override = prv_find_override(node->id, "id", overrides, num_overrides);
+    const char *id = override ? layout_own_string(layout, data, 0, override->value) : node->id;
+    if (id) layout_set_id(layout, (char *) id, data);
+
+    override = prv_find_override(node->id, "frame", overrides, num_overrides);
+    if (override) {
+        type->funcs.set_frame(object, json_parse_grect(override->value, strlen(override->value)));
+    } else if (node->has_frame) {
+        type->funcs.set_frame(object, node->frame);
+    }
+
+    for (uint8_t i = 0; i < node->num_values; i++) {
+        struct TemplateValue *value = &node->values[i];
+        const LayoutProperty *property = &type->funcs.properties[value->property];
+        if (property->kind == LayoutPropertyLayers) {
+            for (uint16_t j = 0; j < value->num_children; j++) {
+                LayoutValue child = { .layer = prv_instantiate(this, &value->children[j], overrides, num_overrides) };
+                property->set(layout, object, child);
+            }
+        } else if (!prv_find_override(node->id, property->name, overrides, num_overrides)) {
+            property->set(layout, object, value->value);
+        }
+    }
+
+    // Overrides may also set properties the template leaves out.
+    for (uint8_t i = 0; node->id && i < num_overrides; i++) {
+        override = &overrides[i];
+        if (strcmp(override->id, node->id) != 0) continue;
+        size_t len = strlen(override->property);
+        int index = layout_type_find_property(type, dict_hash(override->property, len), override->property, len);
+        LayoutValue value;
+        if (index < 0 || type->funcs.properties[index].kind == LayoutPropertyLayers) continue;
+        if (layout_decode_value(layout, type, index, override->value, &value)) {
+            type->funcs.properties[index].set(layout, object, value);
+        }
+    }
+
+    return type->funcs.get_layer(object);
+}
+
+Layer *layout_template_instantiate(LayoutTemplate *this, const LayoutOverride *overrides, uint8_t num_overrides) {
+    logf();
+    if (!this->root) return NULL;
+    return prv_instantiate(this, this->root, overrides, num_overrides);
+}
+
+static bool prv_in_instance(Layer *layer, Layer *root) {
+    logf();
+    for (; layer; layer = layer_get_parent(layer)) {
+        if (layer == root) return true;
+    }
+    return false;
+}
+
+static bool prv_destroy_instance_layer(struct LayerData *data, void *context) {
+    logf();
+    struct Instance *instance = (struct Instance *) context;
+    Layout *layout = instance->layout;
+    if (!prv_in_instance(data->type->funcs.get_layer(data->object), instance->root)) return true;
+    if (data->bound) layout_unbind(layout, data, -1);
+    if (data->id && dict_get(layout->ids, data->id) == data) dict_remove(layout->ids, data->id);
+    layout_destroy_object(layout, data);
+    layout_recycle_data(layout, data);
+    return true;
+}
+
+void layout_template_destroy_instance(LayoutTemplate *this, Layer *layer) {
+    logf();
+    if (!layer) return;
+    layer_remove_from_parent(layer);
+    struct Instance instance = {
+        .layout = this->layout,
+        .root = layer
+    };
+    // Newest first, so children go before their parents and the walk up from each layer still works.
+    layout_registry_foreach(this->layout, true, prv_destroy_instance_layer, &instance);
+}
@@ -0,0 +1,276 @@
+#include <pebble.h>
+#include "string.h"
+#include "logging.h"
+#include "arena.h"
+#include "json.h"
+#include "layout-private.h"
+#include "pebble-layout.h"
+
+#define UPDATE_INLINE_MEMBERS 16
+#define UPDATE_FRAME_HASH 0
+
+struct Update {
+    Layout *layout;
+    Json *json;
+    Dict *old_ids;
+    // Set when the layout holds buffers that this update releases, so kept strings and ids
+    // pointing into them are taken from the new document instead.
+    bool repoint;
+};
+
+struct RootSearch {
+    Layer *root;
+    struct LayerData *data;
+};
+
+// Hash of the next value's JSON text, without consuming it.
+static uint32_t prv_value_hash(Json *json) {
+    logf();
+    int16_t index = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    uint32_t hash = dict_hash(json_token_text(json, tok), tok->len);
+    json_set_index(json, index);
+    return hash;
+}
+
+// Returns whether the value at slot differs from what was applied last time, and records it.
+static bool prv_changed(struct Update *this, struct LayerData *data, bool reused, int slot) {
+    logf();
+    uint32_t hash = prv_value_hash(this->json);
+    if (!data->hashes) {
+        struct LayoutType *type = data->type;
+        size_t size = sizeof(uint32_t) * (1 + type->num_properties);
+        data->hashes = type->free_hashes;
+        if (data->hashes) {
+            type->free_hashes = *(void **) data->hashes;
+        } else {
+            data->hashes = arena_alloc(this->layout->arena, size);
+        }
+        memset(data->hashes, 0, size);
+    }
+    bool changed = !reused || data->hashes[slot] != hash;
+    data->hashes[slot] = hash;
+    return changed;
+}
+
+// Whether the members still set everything the layer had set. Types have no defaults to
+// reset a value to, so a layer whose document drops one is created again instead.
+static bool prv_keeps_values(struct Update *this, struct LayerData *data, int16_t *members, int size) {
+    logf();
+    Json *json = this->json;
+    const LayoutProperty *properties = data->type->funcs.properties;
+    for (int slot = 0; slot <= data->type->num_properties; slot++) {
+        // Children left out are destroyed as stale anyway.
+        if (slot > 0 && properties[slot - 1].kind == LayoutPropertyLayers) continue;
+        if (!layout_was_applied(data, slot)) continue;
+        const char *name = slot == UPDATE_FRAME_HASH ? "frame" : properties[slot - 1].name;
+        bool found = false;
+        for (int i = 0; i < size && !found; i++) {
+            json_set_index(json, members[i]);
+            found = json_eq(json, json_next(json), name);
+        }
+        if (!found) return false;
+    }
+    return true;
+}
+
+// An id the old layout had keeps the string it was registered with, even if its layer is
+// recreated.
+static char *prv_keep_id(struct Update *this, char *old, const char *id) {
+    logf();
+    if (old && !this->repoint && strcmp(old, id) == 0) return old;
+    return layout_keep_string(this->layout, id);
+}
+
+static struct LayerData *prv_update_layer(struct Update *this, struct LayerData *match, struct LayerData *parent);
+
+static void prv_update_layers(struct Update *this, struct LayerData *data, int index) {
+    logf();
+    Json *json = this->json;
+    int16_t start = json_get_index(json);
+    JsonToken *tok = json_next(json);
+    if (tok->type != JSON_ARRAY) {
+        json_set_index(json, start);
+        json_skip_tree(json);
+        return;
+    }
+    const LayoutProperty *property = &data->type->funcs.properties[index];
+    int size = tok->size;
+    for (int i = 0; i < size; i++) {
+        struct LayerData *child = prv_update_layer(this, NULL, data);
+        if (!child) continue;
+        LayoutValue value = { .layer = child->type->funcs.get_layer(child->object) };
+        property->set(this->layout, data->object, value);
+    }
+}
+
+static struct LayerData *prv_update_layer(struct Update *this, struct LayerData *match, struct LayerData *parent) {
+    logf();
+    Layout *layout = this->layout;
+    Json *json = this->json;
+    JsonToken *tok = json_next(json);
+    if (tok->type != JSON_OBJECT) return NULL;
+
+    JsonToken *orig = tok;
+    int size = tok->size;
+    int16_t inline_members[UPDATE_INLINE_MEMBERS];
+    int16_t *members = size <= UPDATE_INLINE_MEMBERS ? inline_members : malloc(sizeof(int16_t) * size);
+    int16_t start = json_get_index(json);
+    const char *type_name = NULL;
+    const char *id = NULL;
+    int16_t stack_member = -1;
+    for (int i = 0; i < size; i++) {
+        members[i] = json_get_index(json);
+        tok = json_next(json);
+        if (json_eq(json, tok, "stack")) {
+            stack_member = members[i];
+        } else if (json_eq(json, tok, "type")) {
+            type_name = json_next_string_view(json);
+            json_set_index(json, members[i] + 1);
+        } else if (json_eq(json, tok, "id")) {
+            id = json_next_string_view(json);
+            json_set_index(json, members[i] + 1);
+        }
+        json_skip_tree(json);
+    }
+    int16_t end = json_get_index(json);
+    struct LayoutType *type = layout_get_type(layout, (char *) type_name);
+
+    // Reuse the existing layer with this id, or the old root for the root, if it has the same
+    // type, has not been claimed yet this update and can be updated in place.
+    struct LayerData *data = match;
+    if (id) data = dict_get(this->old_ids, (char *) id);
+    if (id && !data) data = match;
+    bool reused = data && data->type == type && data->generation != layout->generation &&
+        (type->funcs.properties || type->funcs.update);
+    if (reused && type->funcs.properties) reused = prv_keeps_values(this, data, members, size);
+    char *old_id = NULL;
+
+    if (reused) {
+        Layer *layer = type->funcs.get_layer(data->object);
+        if (layer != layout->root) layer_remove_from_parent(layer);
+        if (!type->funcs.properties) {
+            json_set_index(json, start);
+            type->funcs.update(layout, data->object, json, orig);
+        }
+        data->generation = layout->generation;
+        old_id = data->id;
+        data->id = NULL;
+    } else {
+        if (data) old_id = data->id;
+        if (type->funcs.properties) {
+            data = layout_create_object(layout, type, NULL, NULL);
+        } else {
+            json_set_index(json, start);
+            data = layout_create_object(layout, type, json, orig);
+        }
+    }
+    data->applied = 0;
+
+    if (id) layout_set_id(layout, prv_keep_id(this, old_id, id), data);
+
+    // As when parsing, children need to know they are in a stack before they are linked.
+    if (stack_member >= 0) {
+        json_set_index(json, stack_member);
+        layout_read_box_member(layout, data, json, json_next(json));
+    }
+
+    for (int i = 0; i < size; i++) {
+        json_set_index(json, members[i]);
+        tok = json_next(json);
+        int property = -1;
+        if (json_eq(json, tok, "frame")) {
+            // A box keeps the frame as written, so reading it again only sets that.
+            if (prv_changed(this, data, reused, UPDATE_FRAME_HASH) || data->box) {
+                layout_read_box_member(layout, data, json, tok);
+            } else {
+                layout_note_applied(data, UPDATE_FRAME_HASH);
+            }
+        } else if (!layout_read_box_member(layout, data, json, tok) && type->funcs.properties && tok->type == JSON_STRING &&
+                (property = layout_type_find_property(type, dict_hash(json_token_text(json, tok), tok->len),
+                    json_token_text(json, tok), tok->len)) >= 0) {
+            if (type->funcs.properties[property].kind == LayoutPropertyLayers) {
+                prv_update_layers(this, data, property);
+            } else if (prv_changed(this, data, reused, 1 + property) ||
+                    (this->repoint && type->funcs.properties[property].kind == LayoutPropertyString)) {
+                layout_apply_property(layout, data, property, json);
+            } else {
+                layout_note_applied(data, 1 + property);
+            }
+        }
+    }
+    json_set_index(json, end);
+    layout_attach_box(layout, data, parent);
+
+    if (members != inline_members) free(members);
+    return data;
+}
+
+static bool prv_reset_box(struct LayerData *data, void *context) {
+    logf();
+    layout_reset_box((Layout *) context, data);
+    // The lazy subtree that created the layer is gone, and its record may be used again.
+    data->owner = NULL;
+    return true;
+}
+
+static bool prv_find_root(struct LayerData *data, void *context) {
+    logf();
+    struct RootSearch *search = (struct RootSearch *) context;
+    if (data->type->funcs.get_layer(data->object) != search->root) return true;
+    search->data = data;
+    return false;
+}
+
+// Destroys a layer the update did not reach and recycles its record.
+static bool prv_destroy_stale(struct LayerData *data, void *context) {
+    logf();
+    Layout *this = (Layout *) context;
+    if (data->generation == this->generation) return true;
+    if (data->bound) layout_unbind(this, data, -1);
+    layout_drop_box(this, data);
+    layout_destroy_object(this, data);
+    layout_recycle_data(this, data);
+    return true;
+}
+
+void layout_update_string(Layout *this, char *json_string) {
+    logf();
+    Json *json = json_create(json_string);
+    int16_t index = json_get_index(json);
+    if (!json_has_next(json) || json_next(json)->type != JSON_OBJECT) {
+        loge("layout update is not an object, keeping the current layout");
+        json_destroy(json);
+        return;
+    }
+    json_set_index(json, index);
+
+    struct RootSearch search = { .root = this->root };
+    if (this->root) layout_registry_foreach(this, false, prv_find_root, &search);
+
+    struct Update update = {
+        .layout = this,
+        .json = json,
+        .old_ids = this->ids
+    };
+    this->generation++;
+    this->ids = dict_create();
+    // Lazy subtrees are not tracked across updates; the new document creates everything. Boxes
+    // are kept, but linked and laid out again as the new document says.
+    layout_lazy_reset(this);
+    layout_registry_foreach(this, false, prv_reset_box, this);
+    update.repoint = stack_peek(this->buffers) != NULL;
+
+    this->updating = true;
+    struct LayerData *root = prv_update_layer(&update, search.data, NULL);
+    this->updating = false;
+    dict_destroy(update.old_ids);
+    // Newest first, like layout_destroy().
+    layout_registry_foreach(this, true, prv_destroy_stale, this);
+    layout_set_root(this, root ? root->type->funcs.get_layer(root->object) : NULL);
+
+    // Kept layers now only point into the new document or the arena.
+    if (update.repoint) layout_release_buffers(this);
+    layout_keep_buffer(this, json_detach_buffer(json), json_get_text_size(json));
+    json_destroy(json);
+}
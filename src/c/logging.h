@@ -2,6 +2,9 @@
 
 //#define TRACE
 //#define DEBUG
+// Record logf() calls in a ring buffer instead of logging them, see trace.h. The buffer is
+// dumped after every error and by layout_dump_trace().
+//#define TRACE_BUFFER
 
 #ifdef TRACE
 #define logt(fmt, ...) APP_LOG(APP_LOG_LEVEL_DEBUG_VERBOSE, fmt, ##__VA_ARGS__)
@@ -20,6 +23,11 @@
 
 #define logi(fmt, ...) APP_LOG(APP_LOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
 #define logw(fmt, ...) APP_LOG(APP_LOG_LEVEL_WARNING, fmt, ##__VA_ARGS__)
+#ifdef TRACE_BUFFER
+#include "trace.h"
+#define loge(fmt, ...) (APP_LOG(APP_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__), trace_dump())
+#define logf(void) trace_record(__func__);
+#else
 #define loge(fmt, ...) APP_LOG(APP_LOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
-
 #define logf(void) logt("%s", __func__);
+#endif
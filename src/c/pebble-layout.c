@@ -1,32 +1,41 @@
 #include <pebble.h>
+#include "arena.h"
 #include "stack.h"
 #include "dict.h"
 #include "json.h"
+#include "string.h"
 #include "standard-types.h"
 #include "logging.h"
+#include "layout-private.h"
 #include "pebble-layout.h"
 
-struct Layout {
-    Layer *root;
-    Stack *layers;
-    Dict *ids;
-    Dict *types;
-    Dict *fonts;
-    Dict *resource_ids;
-};
-
-struct LayerData {
-    LayoutFuncs *layout_funcs;
-    void *object;
-};
-
 struct DefaultLayerData {
     GColor color;
 };
 
+#define LAYOUT_ARENA_CHUNK 256
+// Rough arena bytes needed per JSON token: a LayerData and its stack node per object
+// plus the copied strings, spread over every token the object is made of.
+#define LAYOUT_ARENA_BYTES_PER_TOKEN 4
+// Objects with up to this many members are indexed on the stack while they are built.
+#define LAYOUT_INLINE_MEMBERS 16
+
+// A custom font, loaded the first time a layer uses it.
 struct FontInfo {
     GFont font;
-    bool system;
+    uint32_t resource_id;
+    size_t bytes;
+};
+
+// A string that belongs to one layer, such as text an update set in copy mode. It lives on
+// the heap rather than in the arena, so the next value for the same slot takes the same buffer
+// when it fits, and the buffer goes with the layer.
+struct OwnedString {
+    struct OwnedString *next;
+    struct LayerData *data;
+    size_t size;
+    uint8_t slot;
+    char text[];
 };
 
 static void prv_update_proc(Layer *layer, GContext *ctx) {
@@ -38,37 +47,38 @@ static void prv_update_proc(Layer *layer, GContext *ctx) {
     }
 }
 
-static Layer *json_create_layer(Layout *layout, Json *json);
-
 static void *prv_default_create(Layout *layout, Json *json, JsonToken *tok) {
     logf();
     Layer *layer = layer_create_with_data(GRectZero, sizeof(struct DefaultLayerData));
     struct DefaultLayerData *data = layer_get_data(layer);
     data->color = GColorClear;
     layer_set_update_proc(layer, prv_update_proc);
+    return layer;
+}
 
-    int size = tok->size;
-    for (int i = 0; i < size; i++) {
-        tok = json_next(json);
-        if (json_eq(json, tok, "background")) {
-            data->color = json_next_gcolor(json);
-        } else if (json_eq(json, tok, "layers")) {
-            tok = json_next(json);
-            int nsize = tok->size;
-            for (int j = 0; j < nsize; j++) {
-                Layer *child = json_create_layer(layout, json);
-                if (child) layer_add_child(layer, child);
-            }
-        } else if (json_eq(json, tok, "clips")) {
-            layer_set_clips(layer, json_next_bool(json));
-        } else {
-            json_skip_tree(json);
-        }
-    }
+static void prv_default_set_background(Layout *layout, void *object, LayoutValue value) {
+    logf();
+    struct DefaultLayerData *data = layer_get_data((Layer *) object);
+    data->color = value.color;
+}
 
-    return layer;
+static void prv_default_add_layer(Layout *layout, void *object, LayoutValue value) {
+    logf();
+    layer_add_child((Layer *) object, value.layer);
 }
 
+static void prv_default_set_clips(Layout *layout, void *object, LayoutValue value) {
+    logf();
+    layer_set_clips((Layer *) object, value.boolean);
+}
+
+static const LayoutProperty s_default_properties[] = {
+    { "background", LayoutPropertyColor, prv_default_set_background, NULL },
+    { "layers", LayoutPropertyLayers, prv_default_add_layer, NULL },
+    { "clips", LayoutPropertyBool, prv_default_set_clips, NULL },
+    { NULL }
+};
+
 static void prv_default_destroy(void *object) {
     logf();
     layer_destroy((Layer *) object);
@@ -84,67 +94,277 @@ static void prv_default_set_frame(void *object, GRect frame) {
     layer_set_frame((Layer *) object, frame);
 }
 
-static Layer *json_create_layer(Layout *layout, Json *json) {
+static bool prv_name_eq(const char *s, size_t len, const char *name) {
+    logf();
+    return strncmp(s, name, len) == 0 && name[len] == '\0';
+}
+
+int layout_type_find_property(struct LayoutType *type, uint32_t hash, const char *name, size_t len) {
+    logf();
+    for (int i = 0; i < type->num_properties; i++) {
+        if (type->hashes[i].name == hash && prv_name_eq(name, len, type->funcs.properties[i].name)) return i;
+    }
+    return -1;
+}
+
+int layout_type_enum_value(struct LayoutType *type, int property, uint32_t hash, const char *name, size_t len) {
+    logf();
+    const LayoutEnumValue *values = type->funcs.properties[property].values;
+    uint32_t *hashes = type->hashes[property].values;
+    int i = 0;
+    for (; values[i].name; i++) {
+        if (hashes[i] == hash && prv_name_eq(name, len, values[i].name)) break;
+    }
+    // An unknown name falls through to the terminating entry, which holds the default.
+    return values[i].value;
+}
+
+bool layout_decode_value(Layout *this, struct LayoutType *type, int property, const char *text, LayoutValue *value) {
+    logf();
+    size_t len = strlen(text);
+    switch (type->funcs.properties[property].kind) {
+        case LayoutPropertyBool:
+            value->boolean = json_parse_bool(text, len);
+            return true;
+        case LayoutPropertyInt:
+            value->integer = json_parse_int(text, len);
+            return true;
+        case LayoutPropertyColor:
+            value->color = json_parse_gcolor(text, len);
+            return true;
+        case LayoutPropertyString:
+            value->string = layout_copy_string(this, text, len);
+            return value->string != NULL;
+        case LayoutPropertyEnum:
+            value->integer = layout_type_enum_value(type, property, dict_hash(text, len), text, len);
+            return true;
+        case LayoutPropertyFont:
+            value->font = layout_get_font(this, (char *) text);
+            return value->font != NULL;
+        case LayoutPropertyResource: {
+            uint32_t *resource_id = layout_get_resource(this, (char *) text);
+            if (!resource_id) return false;
+            value->resource_id = *resource_id;
+            return true;
+        }
+        case LayoutPropertyRect:
+            value->rect = json_parse_grect(text, len);
+            return true;
+        default:
+            return false;
+    }
+}
+
+static int prv_find_property(struct LayoutType *type, Json *json, JsonToken *tok) {
+    logf();
+    if (tok->type != JSON_STRING) return -1;
+    const char *s = json_token_text(json, tok);
+    return layout_type_find_property(type, dict_hash(s, tok->len), s, tok->len);
+}
+
+static int prv_next_enum(struct LayoutType *type, int index, Json *json) {
+    logf();
+    JsonToken *tok = json_next(json);
+    const char *s = json_token_text(json, tok);
+    return layout_type_enum_value(type, index, dict_hash(s, tok->len), s, tok->len);
+}
+
+void layout_apply_property(Layout *layout, struct LayerData *data, int index, Json *json) {
+    logf();
+    struct LayoutType *type = data->type;
+    void *object = data->object;
+    const LayoutProperty *property = &type->funcs.properties[index];
+    LayoutValue value;
+    layout_note_applied(data, 1 + index);
+    if (property->kind != LayoutPropertyLayers && property->kind != LayoutPropertyRect) {
+        if (data->bound) layout_unbind(layout, data, index);
+        if (layout_bind(layout, data, index, json)) return;
+    }
+    switch (property->kind) {
+        case LayoutPropertyBool:
+            value.boolean = json_next_bool(json);
+            break;
+        case LayoutPropertyInt:
+            value.integer = json_next_int(json);
+            break;
+        case LayoutPropertyColor:
+            value.color = json_next_gcolor(json);
+            break;
+        case LayoutPropertyString: {
+            const char *s = json_next_string_view(json);
+            // Text an update sets may change again, so it goes where the next value can replace it.
+            value.string = layout->updating && !layout->zero_copy ? layout_own_string(layout, data, 1 + index, s) :
+                layout_keep_string(layout, s);
+            if (!value.string) return;
+            break;
+        }
+        case LayoutPropertyEnum:
+            value.integer = prv_next_enum(type, index, json);
+            break;
+        case LayoutPropertyFont: {
+            const char *s = json_next_string_view(json);
+            value.font = s ? layout_get_font(layout, (char *) s) : NULL;
+            if (!value.font) return;
+            break;
+        }
+        case LayoutPropertyResource: {
+            const char *s = json_next_string_view(json);
+            uint32_t *resource_id = s ? layout_get_resource(layout, (char *) s) : NULL;
+            if (!resource_id) return;
+            value.resource_id = *resource_id;
+            break;
+        }
+        case LayoutPropertyRect:
+            value.rect = json_next_grect(json);
+            break;
+        case LayoutPropertyLayers: {
+            int16_t start = json_get_index(json);
+            JsonToken *tok = json_next(json);
+            if (tok->type != JSON_ARRAY) {
+                json_set_index(json, start);
+                json_skip_tree(json);
+                return;
+            }
+            int size = tok->size;
+            struct LayerData *parent = layout->parent;
+            layout->parent = data;
+            for (int i = 0; i < size; i++) {
+                value.layer = layout_create_layer(layout, json, true);
+                if (value.layer) property->set(layout, object, value);
+            }
+            layout->parent = parent;
+            return;
+        }
+    }
+    property->set(layout, object, value);
+}
+
+Layer *layout_create_layer(Layout *layout, Json *json, bool allow_lazy) {
     logf();
     JsonToken *tok = json_next(json);
     if (tok->type != JSON_OBJECT) return NULL;
 
+    // Index the members once, noting "type" on the way, then visit each value directly.
     JsonToken *orig = tok;
-    LayoutFuncs *layout_funcs = NULL;
     int size = tok->size;
-    int16_t index = json_get_index(json);
+    int16_t inline_members[LAYOUT_INLINE_MEMBERS];
+    int16_t *members = size <= LAYOUT_INLINE_MEMBERS ? inline_members : malloc(sizeof(int16_t) * size);
+    int16_t start = json_get_index(json);
+    int16_t type_index = -1;
+    int16_t id_index = -1;
+    int16_t lazy_index = -1;
+    int16_t stack_member = -1;
     for (int i = 0; i < size; i++) {
+        members[i] = json_get_index(json);
         tok = json_next(json);
-        if (json_eq(json, tok, "type")) {
-            char *s = json_next_string(json);
-            layout_funcs = dict_get(layout->types, s);
-            free(s);
-            break;
-        } else {
-            json_skip_tree(json);
+        if (type_index < 0 && json_eq(json, tok, "type")) type_index = json_get_index(json);
+        else if (id_index < 0 && json_eq(json, tok, "id")) id_index = json_get_index(json);
+        else if (lazy_index < 0 && json_eq(json, tok, "lazy")) lazy_index = json_get_index(json);
+        else if (stack_member < 0 && json_eq(json, tok, "stack")) stack_member = members[i];
+        json_skip_tree(json);
+    }
+    int16_t end = json_get_index(json);
+
+    if (allow_lazy && lazy_index >= 0) {
+        json_set_index(json, lazy_index);
+        bool lazy = json_next_bool(json);
+        char *id = NULL;
+        if (lazy && id_index >= 0) {
+            json_set_index(json, id_index);
+            id = layout_keep_string(layout, json_next_string_view(json));
+        }
+        if (lazy && !id) logw("lazy layers need an id to be shown, creating it now");
+        if (id) {
+            json_set_index(json, start - 1);
+            if (members != inline_members) free(members);
+            return layout_add_lazy(layout, id, json);
         }
     }
-    json_set_index(json, index);
 
-    if (layout_funcs == NULL) layout_funcs = dict_get(layout->types, "Layer");
-    index = json_get_index(json);
-    struct LayerData *data = malloc(sizeof(struct LayerData));
-    data->layout_funcs = layout_funcs;
-    data->object = layout_funcs->create(layout, json, orig);
-    stack_push(layout->layers, data);
-    json_set_index(json, index);
+    struct LayoutType *type = NULL;
+    if (type_index >= 0) {
+        json_set_index(json, type_index);
+        type = layout_get_type(layout, (char *) json_next_string_view(json));
+    } else {
+        type = layout_get_type(layout, NULL);
+    }
+
+    struct LayerData *data = NULL;
+    if (type->funcs.properties) {
+        data = layout_create_object(layout, type, NULL, NULL);
+    } else {
+        json_set_index(json, start);
+        data = layout_create_object(layout, type, json, orig);
+    }
+    data->applied = 0;
+    struct LayerData *parent = layout->parent;
+
+    // Children need to know they are in a stack before they are created.
+    if (stack_member >= 0) {
+        json_set_index(json, stack_member);
+        layout_read_box_member(layout, data, json, json_next(json));
+    }
 
     for (int i = 0; i < size; i++) {
+        json_set_index(json, members[i]);
         tok = json_next(json);
+        int property = -1;
         if (json_eq(json, tok, "id")) {
-            char *id = json_next_string(json);
-            dict_put(layout->ids, id, data->object);
-        } else if (json_eq(json, tok, "frame")) {
-            GRect frame = json_next_grect(json);
-            layout_funcs->set_frame(data->object, frame);
-        } else {
-            json_skip_tree(json);
+            char *id = layout_keep_string(layout, json_next_string_view(json));
+            if (id) layout_set_id(layout, id, data);
+        } else if (!layout_read_box_member(layout, data, json, tok) && type->funcs.properties &&
+                (property = prv_find_property(type, json, tok)) >= 0) {
+            layout_apply_property(layout, data, property, json);
         }
     }
+    json_set_index(json, end);
+    layout_attach_box(layout, data, parent);
 
-    return layout_funcs->get_layer(data->object);
+    if (members != inline_members) free(members);
+    return type->funcs.get_layer(data->object);
 }
 
 Layout *layout_create(void) {
     logf();
-    Layout *this = malloc(sizeof(Layout));
+    Arena *arena = arena_create(LAYOUT_ARENA_CHUNK);
+    Layout *this = arena_alloc(arena, sizeof(Layout));
+    this->arena = arena;
     this->root = NULL;
-    this->layers = stack_create();
+    this->first_block = NULL;
+    this->last_block = NULL;
+    this->num_handles = 0;
     this->ids = dict_create();
     this->types = dict_create();
     this->fonts = dict_create();
     this->resource_ids = dict_create();
+    this->buffers = stack_create(arena);
+    this->bindings = dict_create();
+    this->flush_timer = NULL;
+    this->lazy = dict_create();
+    this->materializing = NULL;
+    this->free_data = stack_create(arena);
+    this->free_boxes = NULL;
+    this->free_targets = NULL;
+    this->free_lazy = NULL;
+    this->strings = NULL;
+    this->parent = NULL;
+    this->buffer_bytes = 0;
+    this->string_bytes = 0;
+    this->parse_json_bytes = 0;
+    this->parse_start = 0;
+    this->parse_peak = 0;
+    this->parsing = false;
+    this->updating = false;
+    this->generation = 0;
+    this->zero_copy = false;
+    this->system_fonts = false;
 
     layout_add_type(this, "Layer", (LayoutFuncs) {
         .create = prv_default_create,
         .destroy = prv_default_destroy,
         .get_layer = prv_default_get_layer,
-        .set_frame = prv_default_set_frame
+        .set_frame = prv_default_set_frame,
+        .properties = s_default_properties
     });
 
     return this;
@@ -162,6 +382,73 @@ void layout_add_standard_type(Layout *this, StandardType type) {
     standard_types_add(this, type);
 }
 
+struct LayoutType *layout_get_type(Layout *this, char *name) {
+    logf();
+    struct LayoutType *type = name ? dict_get(this->types, name) : NULL;
+    return type ? type : dict_get(this->types, "Layer");
+}
+
+struct LayerData *layout_add_object(Layout *this, struct LayoutType *type, void *object) {
+    logf();
+    struct LayerData *data = stack_pop(this->free_data);
+    if (!data) data = layout_registry_add(this);
+    data->type = type;
+    data->object = object;
+    data->id = NULL;
+    data->generation = this->generation;
+    data->hashes = NULL;
+    data->bound = false;
+    data->owns_strings = false;
+    data->applied = LAYOUT_APPLIED_UNKNOWN;
+    data->owner = this->materializing;
+    data->box = NULL;
+    return data;
+}
+
+// Gives the record of a destroyed layer back for layout_add_object(). Its hash array goes to
+// its type, as every array of a type has the same size.
+void layout_recycle_data(Layout *this, struct LayerData *data) {
+    logf();
+    if (data->hashes) {
+        *(void **) data->hashes = data->type->free_hashes;
+        data->type->free_hashes = data->hashes;
+        data->hashes = NULL;
+    }
+    data->object = NULL;
+    data->reuses++;
+    stack_push(this->free_data, data);
+}
+
+void layout_note_applied(struct LayerData *data, int slot) {
+    logf();
+    if (slot < LAYOUT_APPLIED_SLOTS) data->applied |= 1 << slot;
+}
+
+// Slots past the tracked ones count as set unless an update has recorded otherwise.
+bool layout_was_applied(struct LayerData *data, int slot) {
+    logf();
+    if (slot < LAYOUT_APPLIED_SLOTS) return data->applied & (1 << slot);
+    return !data->hashes || data->hashes[slot];
+}
+
+void layout_set_id(Layout *this, char *id, struct LayerData *data) {
+    logf();
+    // Lookups find the first layer with an id, so later ones are not registered at all.
+    if (dict_contains(this->ids, id)) return;
+    dict_put(this->ids, id, data);
+    data->id = id;
+}
+
+void layout_set_root(Layout *this, Layer *root) {
+    logf();
+    this->root = root;
+    if (!root) return;
+    GRect frame = layer_get_frame(root);
+    if (grect_equal(&frame, &GRectZero)) {
+        layer_set_frame(root, GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT));
+    }
+}
+
 static void prv_parse(Layout *this, Json *json) {
     if (!json_has_next(json)) goto cleanup;
 
@@ -170,50 +457,170 @@ static void prv_parse(Layout *this, Json *json) {
     if (token->type != JSON_OBJECT) goto cleanup;
     json_set_index(json, index);
 
-    this->root = json_create_layer(this, json);
-    GRect frame = layer_get_frame(this->root);
-    if (grect_equal(&frame, &GRectZero)) {
-        layer_set_frame(this->root, GRect(0, 0, PBL_DISPLAY_WIDTH, PBL_DISPLAY_HEIGHT));
-    }
+    arena_reserve(this->arena, json_get_num_tokens(json) * LAYOUT_ARENA_BYTES_PER_TOKEN);
+    // Every object in a layout is a layer.
+    layout_reserve_layers(this, json_get_num_objects(json));
+#ifdef LAYOUT_PROFILE
+    this->profile.num_tokens = json_get_num_tokens(json);
+#endif
+
+    profile_start(create);
+    Layer *root = layout_create_layer(this, json, true);
+    profile_add(this->profile.create_ms, create);
+    profile_start(root);
+    layout_set_root(this, root);
+    profile_add(this->profile.root_ms, root);
+    layout_stats_end_parse(this, json);
+    layout_keep_buffer(this, json_detach_buffer(json), json_get_text_size(json));
 
 cleanup:
+    if (this->parsing) layout_stats_end_parse(this, json);
     json_destroy(json);
 }
 
+char *layout_copy_string(Layout *this, const char *s, size_t len) {
+    logf();
+    return arena_strndup(this->arena, s, len);
+}
+
+char *layout_keep_string(Layout *this, const char *s) {
+    logf();
+    if (!s || this->zero_copy) return (char *) s;
+    return layout_copy_string(this, s, strlen(s));
+}
+
+char *layout_own_string(Layout *this, struct LayerData *data, int slot, const char *s) {
+    logf();
+    if (!s) return NULL;
+    size_t size = strlen(s) + 1;
+    struct OwnedString **link = &this->strings;
+    if (data->owns_strings) {
+        while (*link && ((*link)->data != data || (*link)->slot != slot)) link = &(*link)->next;
+    }
+    struct OwnedString *string = data->owns_strings ? *link : NULL;
+    if (!string || string->size < size) {
+        size_t old_size = string ? string->size : 0;
+        struct OwnedString *grown = realloc(string, sizeof(struct OwnedString) + size);
+        if (!grown) return NULL;
+        if (string) {
+            this->string_bytes -= old_size;
+            *link = grown;
+        } else {
+            grown->next = this->strings;
+            grown->data = data;
+            grown->slot = slot;
+            this->strings = grown;
+        }
+        string = grown;
+        string->size = size;
+        this->string_bytes += size;
+        data->owns_strings = true;
+    }
+    memcpy(string->text, s, size);
+    return string->text;
+}
+
+void layout_release_strings(Layout *this, struct LayerData *data) {
+    logf();
+    if (!data->owns_strings) return;
+    struct OwnedString **link = &this->strings;
+    while (*link) {
+        struct OwnedString *string = *link;
+        if (string->data != data) {
+            link = &string->next;
+            continue;
+        }
+        *link = string->next;
+        this->string_bytes -= string->size;
+        free(string);
+    }
+    data->owns_strings = false;
+}
+
+void layout_owned_strings_destroy(Layout *this) {
+    logf();
+    while (this->strings) {
+        struct OwnedString *next = this->strings->next;
+        this->string_bytes -= this->strings->size;
+        free(this->strings);
+        this->strings = next;
+    }
+}
+
+void layout_keep_buffer(Layout *this, void *buffer, size_t size) {
+    logf();
+    if (this->zero_copy) {
+        stack_push(this->buffers, buffer);
+        this->buffer_bytes += size;
+    } else {
+        free(buffer);
+    }
+}
+
+void layout_release_buffers(Layout *this) {
+    logf();
+    void *buffer = NULL;
+    while ((buffer = stack_pop(this->buffers)) != NULL) free(buffer);
+    this->buffer_bytes = 0;
+}
+
+void layout_set_zero_copy(Layout *this, bool zero_copy) {
+    logf();
+    this->zero_copy = zero_copy;
+}
+
 void layout_parse(Layout *this, uint32_t resource_id) {
     logf();
-    prv_parse(this, json_create_with_resource(resource_id));
+    layout_stats_begin_parse(this);
+    profile_reset(this);
+    profile_start(load);
+    char *text = json_load_resource(resource_id);
+    profile_add(this->profile.load_ms, load);
+    profile_start(tokenize);
+    Json *json = json_create(text);
+    profile_add(this->profile.tokenize_ms, tokenize);
+    prv_parse(this, json);
 }
 
 void layout_parse_string(Layout *this, char *json) {
     logf();
-    prv_parse(this, json_create(json));
+    layout_stats_begin_parse(this);
+    profile_reset(this);
+    profile_start(tokenize);
+    Json *tokens = json_create(json);
+    profile_add(this->profile.tokenize_ms, tokenize);
+    prv_parse(this, tokens);
 }
 
 static bool prv_fonts_destroy_callback(char *key, void *value, void *context) {
     logf();
     FontInfo *font_info = (FontInfo *) value;
-    if (!font_info->system) fonts_unload_custom_font(font_info->font);
+    if (font_info->font) fonts_unload_custom_font(font_info->font);
     font_info->font = NULL;
-    free(font_info);
     return true;
 }
 
-static bool prv_value_destroy_callback(char *key, void *value, void *context) {
+static bool prv_destroy_layer(struct LayerData *data, void *context) {
     logf();
-    free(value);
-    return true;
-}
-
-static bool prv_key_destroy_callback(char *key, void *value, void *context) {
-    logf();
-    free(key);
+    layout_destroy_object((Layout *) context, data);
     return true;
 }
 
 void layout_destroy(Layout *this) {
     logf();
-    dict_foreach(this->resource_ids, prv_value_destroy_callback, NULL);
+    layout_bindings_destroy(this);
+    layout_owned_strings_destroy(this);
+
+    layout_registry_foreach(this, true, prv_destroy_layer, this);
+    layout_registry_destroy(this);
+    this->root = NULL;
+    stack_destroy(this->free_data);
+    this->free_data = NULL;
+    this->free_boxes = NULL;
+    this->free_targets = NULL;
+    this->free_lazy = NULL;
+    layout_lazy_destroy(this);
+
     dict_destroy(this->resource_ids);
     this->resource_ids = NULL;
 
@@ -221,24 +628,19 @@ void layout_destroy(Layout *this) {
     dict_destroy(this->fonts);
     this->fonts = NULL;
 
-    dict_foreach(this->types, prv_value_destroy_callback, NULL);
     dict_destroy(this->types);
     this->types = NULL;
 
-    dict_foreach(this->ids, prv_key_destroy_callback, NULL);
     dict_destroy(this->ids);
     this->ids = NULL;
 
-    struct LayerData *data = NULL;
-    while ((data = stack_pop(this->layers)) != NULL) {
-        data->layout_funcs->destroy(data->object);
-        free(data);
-    }
-    stack_destroy(this->layers);
-    this->layers = NULL;
-    this->root = NULL;
+    layout_release_buffers(this);
+    stack_destroy(this->buffers);
+    this->buffers = NULL;
 
-    free(this);
+    // The layout itself lives in its arena, along with every type, font, resource id,
+    // string and layer record, so this releases them all.
+    arena_destroy(this->arena);
 }
 
 Layer *layout_get_root_layer(Layout *this) {
@@ -248,33 +650,150 @@ Layer *layout_get_root_layer(Layout *this) {
 
 void *layout_find_by_id(Layout *this, char *id) {
     logf();
-    return dict_get(this->ids, id);
+    struct LayerData *data = dict_get(this->ids, id);
+    return data ? data->object : NULL;
 }
 
 void layout_add_type(Layout *this, char *type, LayoutFuncs layout_funcs) {
     logf();
-    LayoutFuncs *copy = malloc(sizeof(LayoutFuncs));
-    memcpy(copy, &layout_funcs, sizeof(LayoutFuncs));
+    struct LayoutType *copy = arena_alloc(this->arena, sizeof(struct LayoutType));
+    copy->funcs = layout_funcs;
+    copy->num_properties = 0;
+    copy->hashes = NULL;
+    copy->num_objects = 0;
+    copy->object_bytes = 0;
+    copy->free_hashes = NULL;
+#ifdef LAYOUT_PROFILE
+    copy->num_created = 0;
+    copy->create_ms = 0;
+#endif
+
+    const LayoutProperty *properties = layout_funcs.properties;
+    if (properties) {
+        // Hash every property and enum value name once, into a single block, so
+        // parsing compares one hash per candidate instead of a string.
+        int num_values = 0;
+        for (; properties[copy->num_properties].name; copy->num_properties++) {
+            const LayoutProperty *property = &properties[copy->num_properties];
+            if (property->kind != LayoutPropertyEnum) continue;
+            for (const LayoutEnumValue *value = property->values; value->name; value++) num_values++;
+        }
+        copy->hashes = arena_alloc(this->arena, sizeof(struct PropertyHash) * copy->num_properties + sizeof(uint32_t) * num_values);
+        uint32_t *value_hashes = (uint32_t *) &copy->hashes[copy->num_properties];
+        for (int i = 0; i < copy->num_properties; i++) {
+            const LayoutProperty *property = &properties[i];
+            copy->hashes[i].name = dict_hash(property->name, strlen(property->name));
+            copy->hashes[i].values = NULL;
+            if (property->kind != LayoutPropertyEnum) continue;
+            copy->hashes[i].values = value_hashes;
+            for (const LayoutEnumValue *value = property->values; value->name; value++) {
+                *value_hashes++ = dict_hash(value->name, strlen(value->name));
+            }
+        }
+    }
+
     dict_put(this->types, type, copy);
 }
 
+// Sorted by name for binary search. Fonts are only looked up when a layer asks for them.
+static const struct SystemFont {
+    const char *name;
+    const char *key;
+} s_system_fonts[] = {
+    { "BITHAM_18_LIGHT_SUBSET", FONT_KEY_BITHAM_18_LIGHT_SUBSET },
+    { "BITHAM_30_BLACK", FONT_KEY_BITHAM_30_BLACK },
+    { "BITHAM_34_LIGHT_SUBSET", FONT_KEY_BITHAM_34_LIGHT_SUBSET },
+    { "BITHAM_34_MEDIUM_NUMBERS", FONT_KEY_BITHAM_34_MEDIUM_NUMBERS },
+    { "BITHAM_42_BOLD", FONT_KEY_BITHAM_42_BOLD },
+    { "BITHAM_42_LIGHT", FONT_KEY_BITHAM_42_LIGHT },
+    { "BITHAM_42_MEDIUM_NUMBERS", FONT_KEY_BITHAM_42_MEDIUM_NUMBERS },
+    { "DROID_SERIF_28_BOLD", FONT_KEY_DROID_SERIF_28_BOLD },
+    { "GOTHIC_09", FONT_KEY_GOTHIC_09 },
+    { "GOTHIC_14", FONT_KEY_GOTHIC_14 },
+    { "GOTHIC_14_BOLD", FONT_KEY_GOTHIC_14_BOLD },
+    { "GOTHIC_18", FONT_KEY_GOTHIC_18 },
+    { "GOTHIC_18_BOLD", FONT_KEY_GOTHIC_18_BOLD },
+    { "GOTHIC_24", FONT_KEY_GOTHIC_24 },
+    { "GOTHIC_24_BOLD", FONT_KEY_GOTHIC_24_BOLD },
+    { "GOTHIC_28", FONT_KEY_GOTHIC_28 },
+    { "GOTHIC_28_BOLD", FONT_KEY_GOTHIC_28_BOLD },
+    { "LECO_20_BOLD_NUMBERS", FONT_KEY_LECO_20_BOLD_NUMBERS },
+    { "LECO_26_BOLD_NUMBERS_AM_PM", FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM },
+    { "LECO_28_LIGHT_NUMBERS", FONT_KEY_LECO_28_LIGHT_NUMBERS },
+    { "LECO_32_BOLD_NUMBERS", FONT_KEY_LECO_32_BOLD_NUMBERS },
+    { "LECO_36_BOLD_NUMBERS", FONT_KEY_LECO_36_BOLD_NUMBERS },
+    { "LECO_38_BOLD_NUMBERS", FONT_KEY_LECO_38_BOLD_NUMBERS },
+    { "LECO_42_NUMBERS", FONT_KEY_LECO_42_NUMBERS },
+    { "ROBOTO_BOLD_SUBSET_49", FONT_KEY_ROBOTO_BOLD_SUBSET_49 },
+    { "ROBOTO_CONDENSED_21", FONT_KEY_ROBOTO_CONDENSED_21 },
+};
+
+static const char *prv_find_system_font(const char *name) {
+    logf();
+    int lo = 0;
+    int hi = ARRAY_LENGTH(s_system_fonts) - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(name, s_system_fonts[mid].name);
+        if (cmp == 0) return s_system_fonts[mid].key;
+        if (cmp < 0) hi = mid - 1;
+        else lo = mid + 1;
+    }
+    return NULL;
+}
+
 void layout_add_font(Layout *this, char *name, uint32_t resource_id) {
     logf();
-    FontInfo *font_info = malloc(sizeof(FontInfo));
-    font_info->font = fonts_load_custom_font(resource_get_handle(resource_id));
-    font_info->system = false;
+    FontInfo *font_info = arena_alloc(this->arena, sizeof(FontInfo));
+    font_info->font = NULL;
+    font_info->resource_id = resource_id;
+    font_info->bytes = 0;
     dict_put(this->fonts, name, font_info);
 }
 
 GFont layout_get_font(Layout *this, char *name) {
     logf();
     FontInfo *font_info = dict_get(this->fonts, name);
-    return font_info ? font_info->font : NULL;
+    if (font_info) {
+        if (!font_info->font) {
+            size_t before = heap_bytes_used();
+            font_info->font = fonts_load_custom_font(resource_get_handle(font_info->resource_id));
+            size_t after = heap_bytes_used();
+            font_info->bytes = after > before ? after - before : 0;
+        }
+        return font_info->font;
+    }
+    const char *key = this->system_fonts ? prv_find_system_font(name) : NULL;
+    return key ? fonts_get_system_font(key) : NULL;
+}
+
+struct FontSize {
+    size_t bytes;
+    uint16_t count;
+};
+
+static bool prv_font_size_callback(char *key, void *value, void *context) {
+    logf();
+    FontInfo *font_info = (FontInfo *) value;
+    struct FontSize *size = (struct FontSize *) context;
+    if (font_info->font) {
+        size->bytes += font_info->bytes;
+        size->count++;
+    }
+    return true;
+}
+
+size_t layout_font_size(Layout *this, uint16_t *count) {
+    logf();
+    struct FontSize size = { 0, 0 };
+    dict_foreach(this->fonts, prv_font_size_callback, &size);
+    *count = size.count;
+    return size.bytes;
 }
 
 void layout_add_resource(Layout *this, char *name, uint32_t resource_id) {
     logf();
-    uint32_t *rid = malloc(sizeof(uint32_t));
+    uint32_t *rid = arena_alloc(this->arena, sizeof(uint32_t));
     memcpy(rid, &resource_id, sizeof(uint32_t));
     dict_put(this->resource_ids, name, rid);
 }
@@ -284,40 +803,7 @@ uint32_t *layout_get_resource(Layout *this, char *name) {
     return dict_get(this->resource_ids, name);
 }
 
-static void prv_add_system_font(Layout *this, char *name, char *font_key) {
-    logf();
-    FontInfo *font_info = malloc(sizeof(FontInfo));
-    font_info->font = fonts_get_system_font(font_key);
-    font_info->system = true;
-    dict_put(this->fonts, name, font_info);
-}
-
 void layout_add_system_fonts(Layout *this) {
     logf();
-    prv_add_system_font(this, "GOTHIC_18_BOLD", FONT_KEY_GOTHIC_18_BOLD);
-    prv_add_system_font(this, "GOTHIC_24", FONT_KEY_GOTHIC_24);
-    prv_add_system_font(this, "GOTHIC_09", FONT_KEY_GOTHIC_09);
-    prv_add_system_font(this, "GOTHIC_14", FONT_KEY_GOTHIC_14);
-    prv_add_system_font(this, "GOTHIC_14_BOLD", FONT_KEY_GOTHIC_14_BOLD);
-    prv_add_system_font(this, "GOTHIC_18", FONT_KEY_GOTHIC_18);
-    prv_add_system_font(this, "GOTHIC_24_BOLD", FONT_KEY_GOTHIC_24_BOLD);
-    prv_add_system_font(this, "GOTHIC_28", FONT_KEY_GOTHIC_28);
-    prv_add_system_font(this, "GOTHIC_28_BOLD", FONT_KEY_GOTHIC_28_BOLD);
-    prv_add_system_font(this, "BITHAM_30_BLACK", FONT_KEY_BITHAM_30_BLACK);
-    prv_add_system_font(this, "BITHAM_42_BOLD", FONT_KEY_BITHAM_42_BOLD);
-    prv_add_system_font(this, "BITHAM_42_LIGHT", FONT_KEY_BITHAM_42_LIGHT);
-    prv_add_system_font(this, "BITHAM_42_MEDIUM_NUMBERS", FONT_KEY_BITHAM_42_MEDIUM_NUMBERS);
-    prv_add_system_font(this, "BITHAM_34_MEDIUM_NUMBERS", FONT_KEY_BITHAM_34_MEDIUM_NUMBERS);
-    prv_add_system_font(this, "BITHAM_34_LIGHT_SUBSET", FONT_KEY_BITHAM_34_LIGHT_SUBSET);
-    prv_add_system_font(this, "BITHAM_18_LIGHT_SUBSET", FONT_KEY_BITHAM_18_LIGHT_SUBSET);
-    prv_add_system_font(this, "ROBOTO_CONDENSED_21", FONT_KEY_ROBOTO_CONDENSED_21);
-    prv_add_system_font(this, "ROBOTO_BOLD_SUBSET_49", FONT_KEY_ROBOTO_BOLD_SUBSET_49);
-    prv_add_system_font(this, "DROID_SERIF_28_BOLD", FONT_KEY_DROID_SERIF_28_BOLD);
-    prv_add_system_font(this, "LECO_20_BOLD_NUMBERS", FONT_KEY_LECO_20_BOLD_NUMBERS);
-    prv_add_system_font(this, "LECO_26_BOLD_NUMBERS_AM_PM", FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM);
-    prv_add_system_font(this, "LECO_32_BOLD_NUMBERS", FONT_KEY_LECO_32_BOLD_NUMBERS);
-    prv_add_system_font(this, "LECO_36_BOLD_NUMBERS", FONT_KEY_LECO_36_BOLD_NUMBERS);
-    prv_add_system_font(this, "LECO_38_BOLD_NUMBERS", FONT_KEY_LECO_38_BOLD_NUMBERS);
-    prv_add_system_font(this, "LECO_42_NUMBERS", FONT_KEY_LECO_42_NUMBERS);
-    prv_add_system_font(this, "LECO_28_LIGHT_NUMBERS", FONT_KEY_LECO_28_LIGHT_NUMBERS);
+    this->system_fonts = true;
 }
@@ -1,47 +1,66 @@
-#include <@smallstoneapps/linked-list/linked-list.h>
+#include <pebble.h>
 #include "logging.h"
+#include "arena.h"
 #include "stack.h"
 
+struct Node {
+    struct Node *next;
+    void *data;
+};
+
 struct Stack {
-    LinkedRoot *root;
+    Arena *arena;
+    struct Node *top;
+    struct Node *unused;
 };
 
-Stack *stack_create(void) {
+Stack *stack_create(Arena *arena) {
     logf();
-    Stack *this = malloc(sizeof(Stack));
-    this->root = NULL;
+    Stack *this = arena_alloc(arena, sizeof(Stack));
+    this->arena = arena;
+    this->top = NULL;
+    this->unused = NULL;
     return this;
 }
 
 void stack_destroy(Stack *this) {
     logf();
-    if (this->root) {
-        linked_list_clear(this->root);
-        free(this->root);
-    }
-    this->root = NULL;
-    free(this);
+    // Nodes and the stack itself belong to the arena.
+    this->top = NULL;
+    this->unused = NULL;
 }
 
 void stack_push(Stack *this, void *data) {
     logf();
-    if (!this->root) this->root = linked_list_create_root();
-    linked_list_prepend(this->root, data);
+    struct Node *node = this->unused;
+    if (node) {
+        this->unused = node->next;
+    } else {
+        node = arena_alloc(this->arena, sizeof(struct Node));
+    }
+    node->data = data;
+    node->next = this->top;
+    this->top = node;
 }
 
 void *stack_pop(Stack *this) {
     logf();
-    if (!this->root) return NULL;
-    void *data = linked_list_get(this->root, 0);
-    linked_list_remove(this->root, 0);
-    if (linked_list_count(this->root) == 0) {
-        free(this->root);
-        this->root = NULL;
-    }
-    return data;
+    struct Node *node = this->top;
+    if (!node) return NULL;
+    this->top = node->next;
+    node->next = this->unused;
+    this->unused = node;
+    return node->data;
 }
 
 void *stack_peek(Stack *this) {
     logf();
-    return (!this->root) ? NULL : linked_list_get(this->root, 0);
+    return this->top ? this->top->data : NULL;
+}
+
+void stack_foreach(Stack *this, StackForEachCallback callback, void *context) {
+    logf();
+    for (struct Node *node = this->top; node; node = node->next) {
+        if (!callback(node->data, context)) break;
+    }
 }
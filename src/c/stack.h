@@ -1,9 +1,13 @@
 #pragma once
+#include "arena.h"
 
 typedef struct Stack Stack;
 
-Stack *stack_create(void);
+typedef bool (*StackForEachCallback)(void *data, void *context);
+
+Stack *stack_create(Arena *arena);
 void stack_destroy(Stack *this);
 void stack_push(Stack *this, void *data);
 void *stack_pop(Stack *this);
 void *stack_peek(Stack *this);
+void stack_foreach(Stack *this, StackForEachCallback callback, void *context);
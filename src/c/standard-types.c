@@ -8,55 +8,66 @@ static void *prv_text_create(Layout *this, Json *json, JsonToken *tok) {
     logf();
     TextLayer *layer = text_layer_create(GRectZero);
     text_layer_set_background_color(layer, GColorClear);
+    return layer;
+}
 
-    int size = tok->size;
-    for (int i = 0; i < size; i++) {
-        tok = json_next(json);
-        if (json_eq(json, tok, "text")) {
-            char *s = json_next_string(json);
-            text_layer_set_text(layer, s);
-        } else if (json_eq(json, tok, "color")) {
-            GColor color = json_next_gcolor(json);
-            text_layer_set_text_color(layer, color);
-        } else if (json_eq(json, tok, "background")) {
-            GColor color = json_next_gcolor(json);
-            text_layer_set_background_color(layer, color);
-        } else if (json_eq(json, tok, "alignment")) {
-            tok = json_next(json);
-            GTextAlignment alignment = GTextAlignmentLeft;
-            if (json_eq(json, tok, "GTextAlignmentRight"))
-                alignment = GTextAlignmentRight;
-            else if (json_eq(json, tok, "GTextAlignmentCenter"))
-                alignment = GTextAlignmentCenter;
-            text_layer_set_text_alignment(layer, alignment);
-        } else if (json_eq(json, tok, "overflow")) {
-            tok = json_next(json);
-            GTextOverflowMode overflow = GTextOverflowModeTrailingEllipsis;
-            if (json_eq(json, tok, "GTextOverflowModeWordWrap"))
-                overflow = GTextOverflowModeWordWrap;
-            else if (json_eq(json, tok, "GTextOverflowModeFill"))
-                overflow = GTextOverflowModeFill;
-            text_layer_set_overflow_mode(layer, overflow);
-        } else if (json_eq(json, tok, "font")) {
-            char *s = json_next_string(json);
-            GFont font = layout_get_font(this, s);
-            free(s);
-            if (font) text_layer_set_font(layer, font);
-        } else {
-            json_skip_tree(json);
-        }
-    }
+static void prv_text_set_text(Layout *this, void *object, LayoutValue value) {
+    logf();
+    text_layer_set_text((TextLayer *) object, value.string);
+}
 
-    return layer;
+static void prv_text_set_color(Layout *this, void *object, LayoutValue value) {
+    logf();
+    text_layer_set_text_color((TextLayer *) object, value.color);
+}
+
+static void prv_text_set_background(Layout *this, void *object, LayoutValue value) {
+    logf();
+    text_layer_set_background_color((TextLayer *) object, value.color);
 }
 
+static void prv_text_set_alignment(Layout *this, void *object, LayoutValue value) {
+    logf();
+    text_layer_set_text_alignment((TextLayer *) object, value.integer);
+}
+
+static void prv_text_set_overflow(Layout *this, void *object, LayoutValue value) {
+    logf();
+    text_layer_set_overflow_mode((TextLayer *) object, value.integer);
+}
+
+static void prv_text_set_font(Layout *this, void *object, LayoutValue value) {
+    logf();
+    text_layer_set_font((TextLayer *) object, value.font);
+}
+
+static const LayoutEnumValue s_text_alignments[] = {
+    { "GTextAlignmentLeft", GTextAlignmentLeft },
+    { "GTextAlignmentCenter", GTextAlignmentCenter },
+    { "GTextAlignmentRight", GTextAlignmentRight },
+    { NULL, GTextAlignmentLeft }
+};
+
+static const LayoutEnumValue s_text_overflow_modes[] = {
+    { "GTextOverflowModeWordWrap", GTextOverflowModeWordWrap },
+    { "GTextOverflowModeTrailingEllipsis", GTextOverflowModeTrailingEllipsis },
+    { "GTextOverflowModeFill", GTextOverflowModeFill },
+    { NULL, GTextOverflowModeTrailingEllipsis }
+};
+
+static const LayoutProperty s_text_properties[] = {
+    { "text", LayoutPropertyString, prv_text_set_text, NULL },
+    { "color", LayoutPropertyColor, prv_text_set_color, NULL },
+    { "background", LayoutPropertyColor, prv_text_set_background, NULL },
+    { "alignment", LayoutPropertyEnum, prv_text_set_alignment, s_text_alignments },
+    { "overflow", LayoutPropertyEnum, prv_text_set_overflow, s_text_overflow_modes },
+    { "font", LayoutPropertyFont, prv_text_set_font, NULL },
+    { NULL }
+};
+
 static void prv_text_destroy(void *object) {
     logf();
-    TextLayer *layer = (TextLayer *) object;
-    char *s = (char *) text_layer_get_text(layer);
-    if (s) free(s);
-    text_layer_set_text(layer, NULL);
-    text_layer_destroy(layer);
+    text_layer_destroy((TextLayer *) object);
 }
 
 static Layer *prv_text_get_layer(void *object) {
@@ -72,67 +83,73 @@ static void prv_text_set_frame(void *object, GRect frame) {
 
 static void *prv_bitmap_create(Layout *this, Json *json, JsonToken *tok) {
     logf();
-    BitmapLayer *layer = bitmap_layer_create(GRectZero);
-
-    int size = tok->size;
-    for (int i = 0; i < size; i++) {
-        tok = json_next(json);
-        if (json_eq(json, tok, "bitmap")) {
-            char *s = json_next_string(json);
-            uint32_t *resource_id = layout_get_resource(this, s);
-            free(s);
-            if (resource_id) {
-                GBitmap *bitmap = gbitmap_create_with_resource(*resource_id);
-                bitmap_layer_set_bitmap(layer, bitmap);
-            }
-        } else if (json_eq(json, tok, "background")) {
-            GColor color = json_next_gcolor(json);
-            bitmap_layer_set_background_color(layer, color);
-        } else if (json_eq(json, tok, "alignment")) {
-            tok = json_next(json);
-            GAlign alignment = GAlignCenter;
-            if (json_eq(json, tok, "GAlignTopLeft"))
-                alignment = GAlignTopLeft;
-            else if (json_eq(json, tok, "GAlignTop"))
-                alignment = GAlignTop;
-            else if (json_eq(json, tok, "GAlignTopRight"))
-                alignment = GAlignTopRight;
-            else if (json_eq(json, tok, "GAlignLeft"))
-                alignment = GAlignLeft;
-            else if (json_eq(json, tok, "GAlignRight"))
-                alignment = GAlignRight;
-            else if (json_eq(json, tok, "GAlignBottomLeft"))
-                alignment = GAlignBottomLeft;
-            else if (json_eq(json, tok, "GAlignBottomRight"))
-                alignment = GAlignBottomRight;
-            bitmap_layer_set_alignment(layer, alignment);
-        } else if (json_eq(json, tok, "compositing")) {
-            tok = json_next(json);
-            GCompOp compositing = GCompOpAssign;
-            if (json_eq(json, tok, "GCompOpAssignInverted"))
-                compositing = GCompOpAssignInverted;
-            else if (json_eq(json, tok, "GCompOpOr"))
-                compositing = GCompOpOr;
-            else if (json_eq(json, tok, "GCompOpAnd"))
-                compositing = GCompOpAnd;
-            else if (json_eq(json, tok, "GCompOpClear"))
-                compositing = GCompOpClear;
-            else if (json_eq(json, tok, "GCompOpSet"))
-                compositing = GCompOpSet;
-            bitmap_layer_set_compositing_mode(layer, compositing);
-        } else {
-            json_skip_tree(json);
-        }
-    }
+    return bitmap_layer_create(GRectZero);
+}
 
-    return layer;
+// A bitmap the app set itself belongs to the layer, as it always has.
+static void prv_bitmap_drop(GBitmap *bitmap) {
+    logf();
+    if (bitmap && !layout_bitmap_release(bitmap)) gbitmap_destroy(bitmap);
 }
 
-static void prv_bitmap_destroy(void *object) {
+static void prv_bitmap_set_bitmap(Layout *this, void *object, LayoutValue value) {
     logf();
     BitmapLayer *layer = (BitmapLayer *) object;
     GBitmap *b = (GBitmap *) bitmap_layer_get_bitmap(layer);
-    if (b) gbitmap_destroy(b);
+    bitmap_layer_set_bitmap(layer, layout_bitmap_acquire(value.resource_id));
+    prv_bitmap_drop(b);
+}
+
+static void prv_bitmap_set_background(Layout *this, void *object, LayoutValue value) {
+    logf();
+    bitmap_layer_set_background_color((BitmapLayer *) object, value.color);
+}
+
+static void prv_bitmap_set_alignment(Layout *this, void *object, LayoutValue value) {
+    logf();
+    bitmap_layer_set_alignment((BitmapLayer *) object, value.integer);
+}
+
+static void prv_bitmap_set_compositing(Layout *this, void *object, LayoutValue value) {
+    logf();
+    bitmap_layer_set_compositing_mode((BitmapLayer *) object, value.integer);
+}
+
+static const LayoutEnumValue s_bitmap_alignments[] = {
+    { "GAlignCenter", GAlignCenter },
+    { "GAlignTopLeft", GAlignTopLeft },
+    { "GAlignTop", GAlignTop },
+    { "GAlignTopRight", GAlignTopRight },
+    { "GAlignLeft", GAlignLeft },
+    { "GAlignRight", GAlignRight },
+    { "GAlignBottomLeft", GAlignBottomLeft },
+    { "GAlignBottom", GAlignBottom },
+    { "GAlignBottomRight", GAlignBottomRight },
+    { NULL, GAlignCenter }
+};
+
+static const LayoutEnumValue s_bitmap_compositing_modes[] = {
+    { "GCompOpAssign", GCompOpAssign },
+    { "GCompOpAssignInverted", GCompOpAssignInverted },
+    { "GCompOpOr", GCompOpOr },
+    { "GCompOpAnd", GCompOpAnd },
+    { "GCompOpClear", GCompOpClear },
+    { "GCompOpSet", GCompOpSet },
+    { NULL, GCompOpAssign }
+};
+
+static const LayoutProperty s_bitmap_properties[] = {
+    { "bitmap", LayoutPropertyResource, prv_bitmap_set_bitmap, NULL },
+    { "background", LayoutPropertyColor, prv_bitmap_set_background, NULL },
+    { "alignment", LayoutPropertyEnum, prv_bitmap_set_alignment, s_bitmap_alignments },
+    { "compositing", LayoutPropertyEnum, prv_bitmap_set_compositing, s_bitmap_compositing_modes },
+    { NULL }
+};
+
+static void prv_bitmap_destroy(void *object) {
+    logf();
+    BitmapLayer *layer = (BitmapLayer *) object;
+    prv_bitmap_drop((GBitmap *) bitmap_layer_get_bitmap(layer));
     bitmap_layer_set_bitmap(layer, NULL);
     bitmap_layer_destroy(layer);
 }
@@ -156,7 +173,8 @@ void standard_types_add(Layout *this, StandardType type) {
                 .create = prv_text_create,
                 .destroy = prv_text_destroy,
                 .get_layer = prv_text_get_layer,
-                .set_frame = prv_text_set_frame
+                .set_frame = prv_text_set_frame,
+                .properties = s_text_properties
             });
             break;
         case StandardTypeBitmap:
@@ -164,7 +182,8 @@ void standard_types_add(Layout *this, StandardType type) {
                 .create = prv_bitmap_create,
                 .destroy = prv_bitmap_destroy,
                 .get_layer = prv_bitmap_get_layer,
-                .set_frame = prv_bitmap_set_frame
+                .set_frame = prv_bitmap_set_frame,
+                .properties = s_bitmap_properties
             });
             break;
         default: break;
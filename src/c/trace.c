@@ -0,0 +1,53 @@
+#include <pebble.h>
+#include "logging.h"
+#include "trace.h"
+#include "pebble-layout.h"
+
+// None of these use logf(), which would record itself.
+
+#ifdef TRACE_BUFFER
+
+struct TraceEntry {
+    const char *func;
+    uint32_t ms;
+};
+
+static struct TraceEntry s_entries[TRACE_BUFFER_SIZE];
+static uint32_t s_count;
+
+static uint32_t prv_now(void) {
+    time_t seconds;
+    uint16_t ms = time_ms(&seconds, NULL);
+    return (uint32_t) seconds * 1000 + ms;
+}
+
+void trace_record(const char *func) {
+    struct TraceEntry *entry = &s_entries[s_count++ % TRACE_BUFFER_SIZE];
+    entry->func = func;
+    entry->ms = prv_now();
+}
+
+void trace_dump(void) {
+    uint32_t count = s_count < TRACE_BUFFER_SIZE ? s_count : TRACE_BUFFER_SIZE;
+    uint32_t first = s_count - count;
+    if (!count) return;
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "trace: last %d of %d calls", (int) count, (int) s_count);
+    uint32_t start = s_entries[first % TRACE_BUFFER_SIZE].ms;
+    for (uint32_t i = first; i < s_count; i++) {
+        struct TraceEntry *entry = &s_entries[i % TRACE_BUFFER_SIZE];
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "trace: %5d ms %s", (int) (entry->ms - start), entry->func);
+    }
+}
+
+void trace_clear(void) {
+    s_count = 0;
+}
+#endif
+
+void layout_dump_trace(void) {
+#ifdef TRACE_BUFFER
+    trace_dump();
+#else
+    logw("tracing is not compiled in, define TRACE_BUFFER");
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <pebble.h>
+
+#ifndef TRACE_BUFFER_SIZE
+#define TRACE_BUFFER_SIZE 256
+#endif
+
+// Records a function entry in a fixed ring buffer. The name's address is its id: __func__
+// is a distinct string per function, so ids are assigned when the app is linked and
+// recording is a store and a clock read instead of a log message.
+void trace_record(const char *func);
+// Logs the recorded entries, oldest first, with the time each was reached.
+void trace_dump(void);
+void trace_clear(void);
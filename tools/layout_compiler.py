@@ -0,0 +1,226 @@
+#!/usr/bin/env python
+#
+# Compiles pebble-layout JSON files into the binary form read by
+# layout_parse_binary(). Usable from the command line:
+#
+#     python tools/layout_compiler.py layout.json layout.bin
+#
+# or from a wscript, see build().
+#
+import json
+import re
+import struct
+import sys
+from collections import OrderedDict
+
+MAGIC = b'PLYT'
+VERSION = 1
+
+NONE = 0xFFFF
+
+FLAG_ID = 1 << 0
+FLAG_FRAME = 1 << 1
+
+TAG_BOOL = 1
+TAG_INT = 2
+TAG_COLOR = 3
+TAG_STRING = 4
+TAG_ENUM = 5
+TAG_RECT = 6
+TAG_LAYERS = 7
+
+COLOR_PROPERTIES = ('background', 'color')
+
+
+def enum_table(names):
+    return dict((name, i) for i, name in enumerate(names))
+
+
+# Enum properties of the standard types, by type and property name. Values of any other
+# property, including enums of custom types, are left as strings for the loader to resolve.
+ENUMS = {
+    ('TextLayer', 'alignment'): enum_table(['GTextAlignmentLeft', 'GTextAlignmentCenter', 'GTextAlignmentRight']),
+    ('TextLayer', 'overflow'): enum_table(['GTextOverflowModeWordWrap', 'GTextOverflowModeTrailingEllipsis',
+                                           'GTextOverflowModeFill']),
+    ('BitmapLayer', 'alignment'): enum_table(['GAlignCenter', 'GAlignTopLeft', 'GAlignTopRight', 'GAlignTop',
+                                              'GAlignLeft', 'GAlignBottom', 'GAlignRight', 'GAlignBottomRight',
+                                              'GAlignBottomLeft']),
+    ('BitmapLayer', 'compositing'): enum_table(['GCompOpAssign', 'GCompOpAssignInverted', 'GCompOpOr',
+                                                'GCompOpAnd', 'GCompOpClear', 'GCompOpSet']),
+}
+
+HEX_COLOR = re.compile(r'^#?([0-9A-Fa-f]{6})$')
+
+# Matches the "{name}" and "{name:size}" placeholders of bindings, see layout-bindings.c.
+PLACEHOLDER = re.compile(r'^\{[A-Za-z0-9_]+(:[0-9]+)?\}$')
+
+# Members the JSON parser understands but binary layouts cannot express. Rather than build a
+# layout that looks different on the watch, the compiler refuses them.
+UNSUPPORTED = ('lazy', 'anchor', 'stack', 'spacing', 'if')
+
+
+class LayoutError(Exception):
+    pass
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in bytearray(data):
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def gcolor8(rgb):
+    # Matches GColorFromHEX(): two bits per channel, fully opaque.
+    r, g, b = (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF
+    return (3 << 6) | ((r >> 6) << 4) | ((g >> 6) << 2) | (b >> 6)
+
+
+def is_number(value):
+    return isinstance(value, (int, float)) and not isinstance(value, bool)
+
+
+def is_text(value):
+    try:
+        return isinstance(value, (str, unicode))
+    except NameError:
+        return isinstance(value, str)
+
+
+class Compiler(object):
+    def __init__(self):
+        self.strings = []
+        self.string_index = {}
+
+    def intern(self, s):
+        if s not in self.string_index:
+            if len(self.strings) >= NONE:
+                raise LayoutError('too many strings')
+            self.string_index[s] = len(self.strings)
+            self.strings.append(s)
+        return self.string_index[s]
+
+    def rect(self, value):
+        return struct.pack('<hhhh', *[int(v) for v in value])
+
+    def value(self, type_name, key, value):
+        if isinstance(value, bool):
+            return struct.pack('<BB', TAG_BOOL, 1 if value else 0)
+        if is_number(value):
+            return struct.pack('<Bi', TAG_INT, int(value))
+        if is_text(value):
+            match = HEX_COLOR.match(value)
+            if key in COLOR_PROPERTIES and match:
+                return struct.pack('<BB', TAG_COLOR, gcolor8(int(match.group(1), 16)))
+            enum = ENUMS.get((type_name, key), {})
+            if value in enum:
+                return struct.pack('<Bi', TAG_ENUM, enum[value])
+            return struct.pack('<BH', TAG_STRING, self.intern(value))
+        if isinstance(value, list):
+            if all(isinstance(v, dict) for v in value):
+                if len(value) > NONE:
+                    raise LayoutError('too many layers in "%s"' % key)
+                return struct.pack('<BH', TAG_LAYERS, len(value)) + b''.join(self.node(v) for v in value)
+            if len(value) == 4 and all(is_number(v) for v in value):
+                return struct.pack('<B', TAG_RECT) + self.rect(value)
+        return None
+
+    def check(self, obj):
+        name = '"%s"' % obj['id'] if is_text(obj.get('id')) else 'a layer'
+        for key, value in obj.items():
+            if '@' in key:
+                raise LayoutError('%s: conditions such as "%s" are not supported in binary layouts' % (name, key))
+            if key in UNSUPPORTED:
+                raise LayoutError('%s: "%s" is not supported in binary layouts' % (name, key))
+            if is_text(value) and PLACEHOLDER.match(value):
+                raise LayoutError('%s: bindings such as "%s" are not supported in binary layouts' % (name, value))
+        frame = obj.get('frame')
+        if frame is not None and not (isinstance(frame, list) and len(frame) == 4 and all(is_number(v) for v in frame)):
+            raise LayoutError('%s: frames must be four numbers in binary layouts' % name)
+
+    def node(self, obj):
+        self.check(obj)
+        type_name = obj.get('type') if is_text(obj.get('type')) else None
+        type_ref = self.intern(type_name) if type_name else NONE
+        flags = 0
+        head = b''
+        if is_text(obj.get('id')):
+            flags |= FLAG_ID
+            head += struct.pack('<H', self.intern(obj['id']))
+        frame = obj.get('frame')
+        if isinstance(frame, list) and len(frame) == 4 and all(is_number(v) for v in frame):
+            flags |= FLAG_FRAME
+            head += self.rect(frame)
+
+        properties = []
+        for key, value in obj.items():
+            if key in ('type', 'id', 'frame'):
+                continue
+            encoded = self.value(type_name, key, value)
+            if encoded is None:
+                sys.stderr.write('layout_compiler: dropping unsupported value for "%s"\n' % key)
+                continue
+            properties.append(struct.pack('<H', self.intern(key)) + encoded)
+        if len(properties) > 0xFF:
+            raise LayoutError('too many properties')
+
+        return struct.pack('<HBB', type_ref, flags, len(properties)) + head + b''.join(properties)
+
+    def compile(self, root):
+        if not isinstance(root, dict):
+            raise LayoutError('root must be an object')
+        body = self.node(root)
+
+        hashes = b''
+        offsets = b''
+        table = b''
+        for s in self.strings:
+            data = s.encode('utf-8')
+            hashes += struct.pack('<I', fnv1a(data))
+            offsets += struct.pack('<H', len(table))
+            table += data + b'\0'
+        if len(table) > NONE:
+            raise LayoutError('string table too large')
+
+        header = MAGIC + struct.pack('<BBHH', VERSION, 0, len(self.strings), len(table))
+        return header + hashes + offsets + table + body
+
+
+def compile_layout(text):
+    return Compiler().compile(json.loads(text, object_pairs_hook=OrderedDict))
+
+
+def build(ctx, sources):
+    """Adds a task per JSON layout node in sources that writes a .bin next to it, so the result
+    can be listed as a raw resource in package.json. Returns the output nodes."""
+    outputs = []
+    for source in sources:
+        target = source.change_ext('.bin')
+
+        def run(task):
+            data = compile_layout(task.inputs[0].read())
+            task.outputs[0].write(data, 'wb')
+
+        ctx(rule=run, source=source, target=target)
+        outputs.append(target)
+    return outputs
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: %s layout.json layout.bin\n' % argv[0])
+        return 2
+    with open(argv[1], 'r') as f:
+        try:
+            data = compile_layout(f.read())
+        except LayoutError as e:
+            sys.stderr.write('layout_compiler: %s: %s\n' % (argv[1], e))
+            return 1
+    with open(argv[2], 'wb') as f:
+        f.write(data)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))